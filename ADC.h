@@ -17,12 +17,85 @@
 // References           : none
 //
 // Revision History     : Initial version 
-// 
+//                        10/19/26 free-running oversampled acquisition
+//                        10/19/26 multi-channel scan sequencer
+//                        10/19/26 high-rate capture mode
+//                        10/19/26 per-channel median filter
 //
 //**************************************************************************
 
+//ADC inputs on PORTF the sensors are wired to
+#define ADC_CH_LIGHT    0
+#define ADC_CH_SOIL     1
+#define ADC_CH_CO2_B    6
+#define ADC_CH_CO2      7
+
+//Slots of the scan list used by the application. A slot is the position of a
+//channel in the list given to ADC_scan_config, and results are read by slot.
+#define ADC_SLOT_CO2    0
+#define ADC_SLOT_LIGHT  1
+#define ADC_SLOT_SOIL   2
+#define ADC_SLOT_CO2_B  3
+#define ADC_MAX_SLOTS   4
+
+//Extra bits of resolution gained by oversampling. Each result is the sum of
+//4^ADC_OS_BITS conversions decimated by 2^ADC_OS_BITS, so results are
+//10 + ADC_OS_BITS bits wide. ADC_COUNTS converts a 10 bit count to that scale.
+#define ADC_OS_BITS     2
+#define ADC_RESULT_MAX  (1023 << ADC_OS_BITS)
+#define ADC_COUNTS(c)   ((c) << ADC_OS_BITS)
+
+//Output rate settings for ADC_config and ADC_scan_config. Each published
+//result is additionally averaged over 2^rate_shift decimated blocks. With the
+//ADC clock at 125 kHz a conversion takes 104 us, so a result takes
+//104 us * 4^ADC_OS_BITS * 2^rate_shift. With ADC_OS_BITS = 2 the rates below
+//are about 601 Hz, 75 Hz, 9.4 Hz and 1.2 Hz, shared between the scanned
+//channels.
+#define ADC_RATE_FAST   0
+#define ADC_RATE_75HZ   3
+#define ADC_RATE_9HZ    6
+#define ADC_RATE_1HZ    9
+
+//Median filter sizes for ADC_set_median. Every raw conversion of a slot is
+//replaced by the median of its last N conversions before it is accumulated,
+//which removes single spikes without smearing them into the average.
+#define ADC_MEDIAN_OFF  0
+#define ADC_MEDIAN_3    3
+#define ADC_MEDIAN_5    5
+#define ADC_MEDIAN_7    7
+
+//ADC clock prescaler settings for ADC_capture_start, written to the ADPS bits.
+//A conversion takes 13 ADC clocks, so these are about 77, 38 and 19 kSa/s.
+//Above 200 kHz of ADC clock the low bits lose accuracy, which is acceptable
+//for looking at noise but not for measurements.
+#define ADC_CAPTURE_77K 4
+#define ADC_CAPTURE_38K 5
+#define ADC_CAPTURE_19K 6
+
 /**
 *  These functions are located in ADC_drivers.c
 */
-extern void ADC_config();
+extern void ADC_config(unsigned char channel, unsigned char rate_shift);
+extern void ADC_scan_config(const unsigned char *channels, unsigned char count,
+                            unsigned char rate_shift);
 extern void ADC_single_conversion();
+extern unsigned int ADC_read(unsigned char slot);
+extern void ADC_set_median(unsigned char slot, unsigned char size);
+extern void ADC_capture_start(unsigned char channel, unsigned int *buf,
+                              unsigned int count, unsigned char adps);
+
+/**
+*  One bit per slot, set by ISR_ADC with every new result and cleared by
+*  ADC_read.
+*/
+extern volatile unsigned char adc_ready_mask;
+
+/**
+*  Set by ISR_ADC once a block started by ADC_capture_start is full.
+*/
+extern volatile unsigned char adc_capture_done;
+
+/**
+*  Static SRAM of the ADC module, for the SRAM budget.
+*/
+extern const unsigned int __flash adc_sram_bytes;
@@ -2,6 +2,93 @@
 #include <iom128.h>
 #include <intrinsics.h>
 #include <avr_macros.h>
+#include "ADC.h"
+#include "seqlock.h"
+#include "profile.h"
+
+//Results, one per slot. ISR_ADC publishes them through a sequence lock, so
+//a reader always gets a whole result even if it is interrupted mid-read.
+SEQLOCK(unsigned int) adc_results[ADC_MAX_SLOTS];
+volatile unsigned char adc_ready_mask;
+
+//Scan list as ADMUX values, and the slot being converted
+unsigned char adc_scan_mux[ADC_MAX_SLOTS];
+unsigned char adc_scan_count;
+unsigned char adc_slot;
+
+//Median filter state. adc_med_size holds the filter size of each slot, the
+//window of the slot being converted is adc_med_win, filled to adc_med_fill
+//and written at adc_med_pos.
+unsigned char adc_med_size[ADC_MAX_SLOTS];
+unsigned int adc_med_win[ADC_MEDIAN_7];
+unsigned char adc_med_fill;
+unsigned char adc_med_pos;
+
+//Capture state used by ISR_ADC. While adc_capture_left is not zero every
+//conversion is stored raw at adc_capture_ptr instead of being accumulated.
+unsigned int *adc_capture_ptr;
+volatile unsigned int adc_capture_left;
+volatile unsigned char adc_capture_done;
+
+//Oversampling state used by ISR_ADC. adc_accum sums the raw conversions of
+//the current block, adc_samples_left counts down to the next result.
+unsigned long adc_accum;
+unsigned int adc_samples_left;
+unsigned int adc_samples_per_result;
+unsigned char adc_result_shift;
+unsigned char adc_discard;
+
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash adc_sram_bytes =
+  sizeof(adc_results) + sizeof(adc_ready_mask) + sizeof(adc_scan_mux)
+  + sizeof(adc_scan_count) + sizeof(adc_slot) + sizeof(adc_med_size)
+  + sizeof(adc_med_win) + sizeof(adc_med_fill) + sizeof(adc_med_pos)
+  + sizeof(adc_capture_ptr) + sizeof(adc_capture_left)
+  + sizeof(adc_capture_done) + sizeof(adc_accum) + sizeof(adc_samples_left)
+  + sizeof(adc_samples_per_result) + sizeof(adc_result_shift)
+  + sizeof(adc_discard);
+
+//Compare-swap used by the sorting networks, leaves a <= b
+#define ADC_SORT(a, b) { if((a) > (b)){ unsigned int t = (a); (a) = (b); (b) = t; } }
+
+//******************************************************************************
+// Function : unsigned int adc_median(unsigned int *p, unsigned char size)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns the median of the first size entries of p using a fixed sorting
+// network, so the cost does not depend on the data. The networks only order
+// as much as is needed to place the median, 3, 7 and 13 compare-swaps for
+// 3, 5 and 7 samples. The entries of p are reordered.
+//
+// At 16 MHz a compare-swap of two ints is about 10 to 15 cycles, so the median
+// of 7 with the copy of the window costs roughly 250 cycles. With the ADC
+// clock at 125 kHz a conversion is 13 * 128 = 1664 cycles, so the filter
+// takes at most about 15% of the time between conversions.
+//
+//******************************************************************************
+unsigned int adc_median(unsigned int *p, unsigned char size){
+  if(size == ADC_MEDIAN_3){
+    ADC_SORT(p[0], p[1]); ADC_SORT(p[1], p[2]); ADC_SORT(p[0], p[1]);
+    return p[1];
+  }
+
+  if(size == ADC_MEDIAN_5){
+    ADC_SORT(p[0], p[1]); ADC_SORT(p[3], p[4]); ADC_SORT(p[0], p[3]);
+    ADC_SORT(p[1], p[4]); ADC_SORT(p[1], p[2]); ADC_SORT(p[2], p[3]);
+    ADC_SORT(p[1], p[2]);
+    return p[2];
+  }
+
+  ADC_SORT(p[0], p[5]); ADC_SORT(p[0], p[3]); ADC_SORT(p[1], p[6]);
+  ADC_SORT(p[2], p[4]); ADC_SORT(p[0], p[1]); ADC_SORT(p[3], p[5]);
+  ADC_SORT(p[2], p[6]); ADC_SORT(p[2], p[3]); ADC_SORT(p[3], p[6]);
+  ADC_SORT(p[4], p[5]); ADC_SORT(p[1], p[4]); ADC_SORT(p[1], p[3]);
+  ADC_SORT(p[3], p[4]);
+  return p[3];
+}
 
 //******************************************************************************
 // Function : void ADC_single_conversion(void)
@@ -11,44 +98,240 @@
 //
 // DESCRIPTION
 // This will simply set the ADSC bit so that an ADC conversion can start through
-// the system. This will actually help make the conversion
+// the system. This will actually help make the conversion. In free-running
+// mode this only starts the first conversion, the rest follow on their own.
 //
 //******************************************************************************
-           
+
 void ADC_single_conversion(){
   SETBIT(ADCSRA, ADSC);         //Simply set the port that starts the conversion
 }
 
 
 //******************************************************************************
-// Function : void ADC_config(unsigned char channel)
-// Date and version : 4/22/18 version 1.0
+// Function : void ADC_scan_config(const unsigned char *channels,
+//                                 unsigned char count, unsigned char rate_shift)
+// Date and version : 10/19/26 version 1.0
 // Target MCU : ATmega128A @ 16MHz
-// Author : Augusto Celis / Michael Anderon
+// Author : Augusto Celis / Michael Anderson
 //
 // DESCRIPTION
-// This will be the setup for our ADC. This system will end up setting up to use
-// interrupts, delay just in case there is a conversion problem, set up the 
-// MUX to read signals from the correct ADC port, and start a single conversion 
-// because the first conversion after single measurmeent setup is not correct.
+// This will be the setup for our ADC. The ADC is put in free-running mode with
+// the conversion complete interrupt enabled, and ISR_ADC walks the list of
+// channels on its own. Each channel in turn gets 4^ADC_OS_BITS * 2^rate_shift
+// conversions, which are decimated into the result for its slot. ADMUX is
+// then switched to the next channel in the list. The CPU is only involved for
+// one addition per conversion, and nothing outside the ISR is needed to keep
+// every slot up to date. The first conversion after setup is not correct, so
+// it is thrown away.
 //
 //******************************************************************************
-void ADC_config(unsigned char channel){
+void ADC_scan_config(const unsigned char *channels, unsigned char count,
+                     unsigned char rate_shift){
+  //Stop any conversion in progress while the scan state changes
+  ADCSRA = 0;
+
+  if(count > ADC_MAX_SLOTS)
+    count = ADC_MAX_SLOTS;
+
+  //This will select the channels as single ended inputs, and will help us
+  //use an external AVCC with a capacitor at AREF
+  for(unsigned char i = 0; i < count; i++){
+    adc_scan_mux[i] = (0 << REFS1) | (1 << REFS0) | (channels[i] & 0x1F);
+    SEQ_WRITE(adc_results[i], 0);
+  }
+  adc_scan_count = count;
+  adc_slot = 0;
+  adc_ready_mask = 0;
+
+  adc_accum = 0;
+  adc_samples_per_result = (1 << (2 * ADC_OS_BITS)) << rate_shift;
+  adc_samples_left = adc_samples_per_result;
+  adc_result_shift = ADC_OS_BITS + rate_shift;
+  adc_discard = 1;
+  adc_med_fill = 0;
+  adc_med_pos = 0;
+
+  ADMUX = adc_scan_mux[0];
+
   //This will set up the interrupt enable, clear out the interrupt
-  //flag, enable the adc itself, and set up the prescalar of 128 due 
-  //to the high clock frequency from the ATMega128
-  ADCSRA = (1 << ADEN) | (0 << ADSC) | (0 << ADFR) | (0 << ADIF)
+  //flag, enable the adc itself in free-running mode, and set up the
+  //prescalar of 128 due to the high clock frequency from the ATMega128
+  ADCSRA = (1 << ADEN) | (0 << ADSC) | (1 << ADFR) | (1 << ADIF)
     |(1 << ADIE) | (1 << ADPS2) | ( 1 << ADPS1) | ( 1 << ADPS0);
-  
-  //Delay in case 
-  __delay_cycles(4000);
-  
-  //This will set up the ADC7 to be the negative input for the ADC, 
-  //and will help us use an external AVCC with a capacitor at AREF
-  ADMUX = (0 << MUX4) | (0 << MUX3) | (1 << MUX2) | 
-           (1 << MUX1) | (1 << MUX0) | (0 << REFS1) | (1 << REFS0);
 
-ADC_single_conversion();        //Get rid of the first cycle of ADC cycles read
+  ADC_single_conversion();        //Start the free-running conversions
+}
+
+//******************************************************************************
+// Function : void ADC_config(unsigned char channel, unsigned char rate_shift)
+// Date and version : 10/19/26 version 1.2
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderon
+//
+// DESCRIPTION
+// Sets up the ADC to convert a single channel continuously. This is a scan
+// list of one, so the result is read from slot 0.
+//
+//******************************************************************************
+void ADC_config(unsigned char channel, unsigned char rate_shift){
+  ADC_scan_config(&channel, 1, rate_shift);
+}
+
+//******************************************************************************
+// Function : void ADC_set_median(unsigned char slot, unsigned char size)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Selects the median filter for a slot, ADC_MEDIAN_OFF or a window of 3, 5 or
+// 7 conversions. The window is refilled every time the scan comes back to the
+// slot, so the first size - 1 conversions after each channel switch only prime
+// the filter. The setting takes effect the next time the slot is converted.
+//
+//******************************************************************************
+void ADC_set_median(unsigned char slot, unsigned char size){
+  if(size != ADC_MEDIAN_3 && size != ADC_MEDIAN_5 && size != ADC_MEDIAN_7)
+    size = ADC_MEDIAN_OFF;
+  adc_med_size[slot] = size;
 }
 
+//******************************************************************************
+// Function : unsigned int ADC_read(unsigned char slot)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns the latest result of a slot and clears the ready bit of the slot.
+// The result is read through the sequence lock of the slot, so interrupts
+// stay enabled while it is copied.
+//
+//******************************************************************************
+unsigned int ADC_read(unsigned char slot){
+  unsigned int result;
+
+  __istate_t state = __get_interrupt_state();
+  __disable_interrupt();
+  adc_ready_mask &= ~(1 << slot);
+  __set_interrupt_state(state);
+
+  SEQ_READ(adc_results[slot], result);
+  return result;
+}
 
+//******************************************************************************
+// Function : void ADC_capture_start(unsigned char channel, unsigned int *buf,
+//                                   unsigned int count, unsigned char adps)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Starts capturing count raw conversions of one channel into buf, at the rate
+// set by the ADC clock prescaler adps (see ADC_CAPTURE_xxx). The ADC runs
+// free and ISR_ADC only stores each sample, so the block is taken at the full
+// conversion rate. When the block is full the ADC is stopped and
+// adc_capture_done is set. This replaces any scan in progress, so
+// ADC_scan_config has to be called again to go back to scanning.
+//
+//******************************************************************************
+void ADC_capture_start(unsigned char channel, unsigned int *buf,
+                       unsigned int count, unsigned char adps){
+  ADCSRA = 0;
+
+  adc_capture_ptr = buf;
+  adc_capture_left = count;
+  adc_capture_done = 0;
+  adc_discard = 1;
+
+  ADMUX = (0 << REFS1) | (1 << REFS0) | (channel & 0x1F);
+
+  ADCSRA = (1 << ADEN) | (0 << ADSC) | (1 << ADFR) | (1 << ADIF)
+    |(1 << ADIE) | (adps & 0x07);
+
+  ADC_single_conversion();
+}
+
+/*
+*Interrupt that is set off by the conversion end of
+*the ADC itself. Every conversion is added to the
+*accumulator, and once the block is complete the sum is
+*decimated and published as the result of the slot, and
+*ADMUX moves on to the next channel.
+*Slots with a median filter accumulate the median of
+*their last conversions instead of the raw sample.
+*In free-running mode the conversion already in progress
+*still uses the old channel, so it is thrown away.
+*Every conversion is profiled, the discarded ones, the
+*capture and the median priming included.
+*/
+#pragma vector = ADC_vect
+__interrupt void ISR_ADC(){
+  PROFILE_ENTER(PROF_ADC);
+  
+  //Reading ADC reads ADCL first, which is needed to unlock ADCH
+  unsigned int sample = ADC;
+
+  if(adc_discard){
+    adc_discard--;
+    goto done;
+  }
+
+  //Capture mode, store the raw sample and stop once the block is full
+  if(adc_capture_left){
+    *adc_capture_ptr++ = sample;
+    if(--adc_capture_left == 0){
+      ADCSRA = 0;
+      adc_capture_done = 1;
+    }
+    goto done;
+  }
+
+  //Median filter, the first conversions of a slot only fill the window
+  unsigned char size = adc_med_size[adc_slot];
+  if(size){
+    adc_med_win[adc_med_pos] = sample;
+    if(++adc_med_pos >= size)
+      adc_med_pos = 0;
+    if(adc_med_fill < size){
+      adc_med_fill++;
+      if(adc_med_fill < size)
+        goto done;
+    }
+
+    unsigned int sorted[ADC_MEDIAN_7];
+    for(unsigned char i = 0; i < size; i++)
+      sorted[i] = adc_med_win[i];
+    sample = adc_median(sorted, size);
+  }
+
+  adc_accum += sample;
+
+  if(--adc_samples_left == 0){
+    unsigned char slot = adc_slot;
+    unsigned int result = (unsigned int)(adc_accum >> adc_result_shift);
+
+    SEQ_WRITE(adc_results[slot], result);
+    adc_ready_mask |= (1 << slot);
+
+    adc_accum = 0;
+    adc_samples_left = adc_samples_per_result;
+
+    //Move on to the next channel of the scan list
+    if(adc_scan_count > 1){
+      if(++slot == adc_scan_count)
+        slot = 0;
+      adc_slot = slot;
+      ADMUX = adc_scan_mux[slot];
+      adc_discard = 1;
+      adc_med_fill = 0;
+      adc_med_pos = 0;
+    }
+  }
+  
+  //Every path leaves through here so every run is profiled
+done:
+  PROFILE_EXIT(PROF_ADC);
+}
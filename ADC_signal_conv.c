@@ -1,65 +1,151 @@
-#include <stdio.h>
 #include <iom128.h>
 #include <intrinsics.h>
 #include <avr_macros.h>
 #include "lcd.h"
 #include "ADC.h"
+#include "uart.h"
+#include "power.h"
 
-int value;
-
-/*
-*Interrupt that is set off by the conversion end of 
-*the ADC itself. This will setup the value which 
-*will be updated ot the LCD screen
-*/
-#pragma vector = ADC_vect
-__interrupt void ISR_ADC(){
-  value = (int)ADCH << 8;
-  value |= (int)ADCL;
+//#define SCOPE_SERIAL_DUMP   //uncomment to send every block out of USART0
+
+//Channel, rate and length of the captured blocks
+#define SCOPE_CHANNEL   ADC_CH_CO2
+#define SCOPE_RATE      ADC_CAPTURE_77K
+#define SCOPE_SAMPLES   256
+
+//Two capture blocks, one is filled by ISR_ADC while the other is analyzed
+unsigned int scope_block[2][SCOPE_SAMPLES];
+
+//Text of the LCD and the serial dump, kept in flash
+const char __flash str_lo[] = "Lo:";
+const char __flash str_hi[] = " Hi:";
+const char __flash str_peak_peak[] = "P-P:";
+const char __flash str_mean[] = "Mean:";
+#ifdef SCOPE_SERIAL_DUMP
+const char __flash str_dump_channel[] = "# ch ";
+const char __flash str_dump_count[] = " n ";
+#endif
+
+//******************************************************************************
+// Function : void show_block_stats(unsigned int *block)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Finds the minimum, maximum, peak-to-peak and mean of a captured block and
+// shows them on the LCD. The mean is shown with two decimal places of ADC
+// counts, which averaging the block makes meaningful.
+//
+//******************************************************************************
+void show_block_stats(unsigned int *block){
+  unsigned int min = 0xFFFF;
+  unsigned int max = 0;
+  unsigned long sum = 0;
+
+  for(unsigned int i = 0; i < SCOPE_SAMPLES; i++){
+    unsigned int sample = block[i];
+    if(sample < min)
+      min = sample;
+    if(sample > max)
+      max = sample;
+    sum += sample;
+  }
+
+  unsigned long mean_centi = (sum * 100) / SCOPE_SAMPLES;
+
+  clear_dsp();
   
+  char *p = lcd_put_P(lcd_at(0, 0), str_lo);
+  p = lcd_put_uint(p, min, 4);
+  p = lcd_put_P(p, str_hi);
+  lcd_put_uint(p, max, 4);
+  
+  p = lcd_put_P(lcd_at(1, 0), str_peak_peak);
+  lcd_put_uint(p, max - min, 4);
+  
+  p = lcd_put_P(lcd_at(2, 0), str_mean);
+  p = lcd_put_uint(p, (unsigned int)(mean_centi / 100), 4);
+  *p++ = '.';
+  lcd_put_2d(p, (unsigned char)(mean_centi % 100));
+  
+  update_lcd_dog();
 }
 
+#ifdef SCOPE_SERIAL_DUMP
+//******************************************************************************
+// Function : void dump_block(unsigned int *block)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sends a captured block out of the serial port, one hex sample per line,
+// after a header line giving the channel and the sample count.
+//
+//******************************************************************************
+void dump_block(unsigned int *block){
+  uart_puts_P(str_dump_channel);
+  uart_put_uint(SCOPE_CHANNEL);
+  uart_puts_P(str_dump_count);
+  uart_put_uint(SCOPE_SAMPLES);
+  uart_newline();
+
+  for(unsigned int i = 0; i < SCOPE_SAMPLES; i++){
+    uart_put_hex(block[i]);
+    uart_newline();
+  }
+}
+#endif
 
 void main(){
   // Configure PortA for selects of the humidicon and RTC
   DDRA = 0xFF;
   SETBIT(PORTA, 0);     //Select for humidicon (Unassert)
   CLEARBIT(PORTA, 1);   //Select for RTC (Unassert)
-  
+
   //Configure PortB for SPI
   DDRB = 0xF7;          //SCK, MISO, MOSI setup
   SETBIT(PORTB, 0);     //Select for LCD (Unassert)
-  
-  // Configure PortC for keypad, initial configuration
-  DDRC = 0xF0;          // High nibble outputs, low nibble inputs 
-  PORTC = 0x0F;      
-  
-  //Configure PortD for Inerrupts
-  DDRD = 0xF0;          //INT0, INT1, INT2
-  PORTD = 0x0D;         //Set pullup resistors on INT0 and INT2
-  
+
   //Configure Port F for ADC
   DDRF = 0x00;
-  
-  //Enable interrupt config
-  MCUCR = 0X30;
-  EIMSK = 0X07;
+
+  //Only the ADC interrupt is used by this program
   __enable_interrupt();
-  
+
   init_lcd_dog();
-  
-  //This syetm will init the spi, and then update the lcd with the hex value
-  //of the potentiometer
+
+#ifdef SCOPE_SERIAL_DUMP
+  uart_init();
+#endif
+
+  //Start filling the first block
+  unsigned char filling = 0;
+  ADC_capture_start(SCOPE_CHANNEL, scope_block[filling], SCOPE_SAMPLES,
+                    SCOPE_RATE);
+
+  //As soon as a block is full the next capture is started, and the full
+  //block is analyzed and shown while the other one fills
   while(1){
-    init_spi_lcd();
-    clear_dsp();
-    
-    printf("Analog Value:\n");
-    printf("0x");
-    update_lcd_dog();
-    
-    ADC_single_conversion();    //Actually start the ADC conversion
-    printf("%04x", value);      //Show the value that is received from the ADC
+    //Sleep until the block is full. The capture runs the ADC free, so the
+    //CPU sleeps in idle and wakes for every sample.
+    __disable_interrupt();
+    while(!adc_capture_done){
+      power_sleep();
+      __disable_interrupt();
+    }
+    __enable_interrupt();
+
+    unsigned char ready = filling;
+    filling ^= 1;
+    ADC_capture_start(SCOPE_CHANNEL, scope_block[filling], SCOPE_SAMPLES,
+                      SCOPE_RATE);
+
+    show_block_stats(scope_block[ready]);
+
+#ifdef SCOPE_SERIAL_DUMP
+    dump_block(scope_block[ready]);
+#endif
   }
 }
-
@@ -74,7 +74,17 @@
 #define set_alarm_seconds 0x80
 
 //These are the functions that we are using from DS1306_RTC_drivers.c
+//Called once a queued register write is done
+typedef void (*rtc_done_fn_ptr) (void);
+
+//Register writes that can wait in rtc_queue_write for the SPI
+#define RTC_QUEUE_SIZE 4
+
 extern void SPI_rtc_ds1306_config();
+extern unsigned char rtc_queue_write(unsigned char reg_RTC,
+                                     unsigned char data_RTC,
+                                     rtc_done_fn_ptr done);
+extern void rtc_poll(void);
 extern void write_RTC(unsigned char reg_RTC, unsigned char data_RTC);
 extern unsigned char read_RTC(unsigned char reg_RTC);
 extern void write_read_RTC_test(void);
@@ -108,3 +118,5 @@ extern unsigned char hours_ones;
 extern unsigned char minutes_tens;
 extern unsigned char minutes_ones;
 
+//Static SRAM of the RTC module, for the SRAM budget
+extern const unsigned int __flash rtc_sram_bytes;
@@ -2,6 +2,7 @@
 #include <iom128.h>
 #include <intrinsics.h>
 #include "DS1306_RTC.h" 
+#include "lcd.h"
 
 unsigned char RTC_byte[10];
 volatile unsigned char RTC_time_date_write[7];
@@ -24,6 +25,26 @@ unsigned char hours_ones;
 unsigned char minutes_tens;
 unsigned char minutes_ones;
 
+//Register writes waiting for the SPI, oldest at rtc_queue_head
+typedef struct{
+  unsigned char reg;
+  unsigned char data;
+  rtc_done_fn_ptr done;
+} rtc_write_job;
+
+rtc_write_job rtc_queue[RTC_QUEUE_SIZE];
+unsigned char rtc_queue_head;
+unsigned char rtc_queue_count;
+
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash rtc_sram_bytes =
+  sizeof(RTC_byte) + sizeof(RTC_time_date_write) + sizeof(RTC_time_date_read)
+  + sizeof(seconds) + sizeof(minutes) + sizeof(hours)
+  + sizeof(alarm_seconds) + sizeof(alarm_minutes) + sizeof(alarm_hours)
+  + sizeof(seconds_RTC) + sizeof(minutes_RTC) + sizeof(hours_RTC)
+  + sizeof(hours_tens) + sizeof(hours_ones) + sizeof(minutes_tens)
+  + sizeof(minutes_ones)
+  + sizeof(rtc_queue) + sizeof(rtc_queue_head) + sizeof(rtc_queue_count);
 
 //******************************************************************************
 // Function : void SPI_rtc_ds1306_config (void)
@@ -39,6 +60,7 @@ unsigned char minutes_ones;
 //
 //******************************************************************************
 void SPI_rtc_ds1306_config(){
+  lcd_wait();                    //Let the LCD flush finish with the SPI
   CLEARBIT(PORTA, 1);            //Deselect the RTC
   SPCR = (1 << SPE) | (1 << MSTR) | (0 << CPOL) | ( 1 << CPHA) | 
     (0 << SPR1) | (1 <<SPR0);
@@ -88,6 +110,60 @@ void write_RTC(unsigned char reg_RTC, unsigned char data_RTC){
   
 }
 
+//******************************************************************************
+// Function : unsigned char rtc_queue_write(unsigned char reg_RTC,
+//                                          unsigned char data_RTC,
+//                                          rtc_done_fn_ptr done)
+// Date and version : 10/19/26, version 1.0
+// Target MCU : ATmega128 @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Queues a register write for rtc_poll to send once the SPI is free, instead
+// of waiting for an LCD flush to finish. done is called after the write, or
+// may be 0. Returns 0 if the queue is full. Only called from main().
+//
+//******************************************************************************
+unsigned char rtc_queue_write(unsigned char reg_RTC, unsigned char data_RTC,
+                              rtc_done_fn_ptr done){
+  if(rtc_queue_count == RTC_QUEUE_SIZE)
+    return 0;
+  
+  rtc_write_job *job = &rtc_queue[(rtc_queue_head + rtc_queue_count)
+                                  % RTC_QUEUE_SIZE];
+  job->reg = reg_RTC;
+  job->data = data_RTC;
+  job->done = done;
+  rtc_queue_count++;
+  return 1;
+}
+
+//******************************************************************************
+// Function : void rtc_poll(void)
+// Date and version : 10/19/26, version 1.0
+// Target MCU : ATmega128 @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sends the queued register writes while the SPI is not busy with an LCD
+// flush. Called from the main loop, it returns right away when there is
+// nothing to send or the flush still has the SPI.
+//
+//******************************************************************************
+void rtc_poll(void){
+  while(rtc_queue_count && !lcd_flushing){
+    rtc_write_job job = rtc_queue[rtc_queue_head];
+    
+    rtc_queue_head = (rtc_queue_head + 1) % RTC_QUEUE_SIZE;
+    rtc_queue_count--;
+    
+    SPI_rtc_ds1306_config();
+    write_RTC(job.reg, job.data);
+    if(job.done)
+      job.done();
+  }
+}
+
 //******************************************************************************
 // Function Name : unsigned char read_RTC (unsigned char reg_RTC)
 // Date and version : 03/11/18, version 1.0
@@ -0,0 +1,48 @@
+//***************************************************************************
+//
+// File Name            : alarm.h
+// Title                : Header file for the alarm output patterns
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @  16MHz
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// This file includes all the declaration the compiler needs to
+// reference the functions and variables written in the file alarm_drivers.c
+//
+// Warnings             : Timer3 is used by the alarm output
+// Restrictions         : none
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//**************************************************************************
+
+//The alarm output is bit 7 of PORTA
+#define ALARM_OUTPUT    7
+
+//Longest on or off time of a step, Timer3 counts 64us up to 0xFFFF
+#define ALARM_STEP_MAX_MS       4000
+
+//One beep of a pattern, the output is on for on_ms and then off for off_ms.
+//A pattern is a list of steps ending with a step whose on_ms is 0.
+typedef struct{
+  unsigned int on_ms;
+  unsigned int off_ms;
+} alarm_step;
+
+//Patterns in alarm_drivers.c
+extern const alarm_step __flash alarm_single[];         //One 1 second pulse
+extern const alarm_step __flash alarm_triple[];         //Three short beeps
+extern const alarm_step __flash alarm_long_short[];     //Long, short, short
+
+//Static SRAM of the alarm module, for the SRAM budget
+extern const unsigned int __flash alarm_sram_bytes;
+
+//These are the functions located in alarm_drivers.c
+extern void alarm_pulse_start(const alarm_step __flash *pattern,
+                              unsigned char plays);
+extern void alarm_pulse_stop(void);
+extern unsigned char alarm_pulse_busy(void);
@@ -0,0 +1,203 @@
+//******************************************************************************
+//
+// File Name            : alarm_drivers.c
+// Title                : Alarm output patterns
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ;
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Plays a beep pattern on the alarm output. Timer3 runs in CTC mode from the
+// clock divided by 1024, 64us a count, and its compare interrupt comes at
+// every edge of the pattern. The interrupt switches the output and loads the
+// time to the next edge, so the pattern takes a few microseconds per edge
+// and nothing waits for it. alarm_pulse_start only sets up the first edge
+// and can be called from an interrupt.
+//
+// Warnings             : none
+// Restrictions         : Steps are at most ALARM_STEP_MAX_MS long
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include <avr_macros.h>
+#include "alarm.h"
+
+//Timer3 CTC with the clock divided by 1024, 15.625 counts a millisecond
+#define ALARM_TCCR3B    ((1 << WGM32) | (1 << CS32) | (1 << CS30))
+
+//Patterns, each ends with a step whose on_ms is 0
+const alarm_step __flash alarm_single[] = {
+  {1000, 0},
+  {0, 0}
+};
+
+const alarm_step __flash alarm_triple[] = {
+  {150, 100},
+  {150, 100},
+  {150, 600},
+  {0, 0}
+};
+
+const alarm_step __flash alarm_long_short[] = {
+  {600, 200},
+  {150, 100},
+  {150, 600},
+  {0, 0}
+};
+
+//Pattern playing, the step the output is in and the plays left
+const alarm_step __flash *alarm_pattern;
+const alarm_step __flash *alarm_step_now;
+unsigned char alarm_plays;
+unsigned char alarm_on;                 //Output is on, in the on_ms part
+volatile unsigned char alarm_busy;
+
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash alarm_sram_bytes =
+  sizeof(alarm_pattern) + sizeof(alarm_step_now) + sizeof(alarm_plays)
+  + sizeof(alarm_on) + sizeof(alarm_busy);
+
+//******************************************************************************
+// Function : void alarm_edge_in(unsigned int ms)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sets the Timer3 compare interrupt to come ms from now.
+//
+//******************************************************************************
+void alarm_edge_in(unsigned int ms){
+  if(ms > ALARM_STEP_MAX_MS)
+    ms = ALARM_STEP_MAX_MS;
+
+  TCNT3 = 0;
+  OCR3A = (unsigned int)(((unsigned long)ms * 125) >> 3) - 1;
+}
+
+//******************************************************************************
+// Function : void alarm_pulse_stop(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Turns the alarm output off and stops the pattern.
+//
+//******************************************************************************
+void alarm_pulse_stop(void){
+  __istate_t state = __get_interrupt_state();
+  __disable_interrupt();
+
+  TCCR3B = 0;
+  CLEARBIT(ETIMSK, OCIE3A);
+  CLEARBIT(PORTA, ALARM_OUTPUT);
+  alarm_on = 0;
+  alarm_busy = 0;
+
+  __set_interrupt_state(state);
+}
+
+//******************************************************************************
+// Function : void alarm_next_edge(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Moves the output to the next edge of the pattern, called with interrupts
+// off. The end of an on_ms turns the output off for off_ms, or goes straight
+// to the next step when off_ms is 0. The end of the pattern starts it over
+// until it has been played the number of times asked for.
+//
+//******************************************************************************
+void alarm_next_edge(void){
+  if(alarm_on){
+    CLEARBIT(PORTA, ALARM_OUTPUT);
+    alarm_on = 0;
+
+    unsigned int off_ms = alarm_step_now->off_ms;
+    alarm_step_now++;
+    if(off_ms){
+      alarm_edge_in(off_ms);
+      return;
+    }
+  }
+
+  if(!alarm_step_now->on_ms){
+    if(--alarm_plays == 0){
+      alarm_pulse_stop();
+      return;
+    }
+    alarm_step_now = alarm_pattern;
+  }
+
+  SETBIT(PORTA, ALARM_OUTPUT);
+  alarm_on = 1;
+  alarm_edge_in(alarm_step_now->on_ms);
+}
+
+//******************************************************************************
+// Function : void alarm_pulse_start(const alarm_step __flash *pattern,
+//                                   unsigned char plays)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Plays a pattern plays times on the alarm output, replacing any pattern
+// already playing. Returns once the first beep has started.
+//
+//******************************************************************************
+void alarm_pulse_start(const alarm_step __flash *pattern, unsigned char plays){
+  if(!plays || !pattern->on_ms)
+    return;
+
+  __istate_t state = __get_interrupt_state();
+  __disable_interrupt();
+
+  alarm_pattern = pattern;
+  alarm_step_now = pattern;
+  alarm_plays = plays;
+  alarm_on = 0;
+  alarm_busy = 1;
+
+  TCCR3A = 0;
+  TCCR3B = ALARM_TCCR3B;
+  alarm_next_edge();
+  ETIFR = (1 << OCF3A);
+  SETBIT(ETIMSK, OCIE3A);
+
+  __set_interrupt_state(state);
+}
+
+//******************************************************************************
+// Function : unsigned char alarm_pulse_busy(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns 1 while a pattern is playing.
+//
+//******************************************************************************
+unsigned char alarm_pulse_busy(void){
+  return alarm_busy;
+}
+
+/*
+*Interrupt set off by Timer3 at every edge of the
+*alarm pattern.
+*/
+#pragma vector = TIMER3_COMPA_vect
+__interrupt void ISR_TIMER3_COMPA(void){
+  alarm_next_edge();
+}
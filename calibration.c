@@ -0,0 +1,105 @@
+//******************************************************************************
+//
+// File Name            : calibration.c
+// Title                : Sensor calibration tables
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ;
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Every sensor channel has a piecewise-linear calibration curve stored in
+// flash. A curve is a sorted list of segments, each holding its start point
+// and a precomputed fixed-point slope, so converting a raw reading is a short
+// binary search followed by one multiply and a shift. No floating point is
+// used anywhere in the conversion.
+//
+// The RH and temperature curves below are the HumidIcon transfer functions
+// from the data sheet. Offset and slope corrections for a particular unit are
+// made by moving the end points. The CO2 curve is the bench curve for the
+// 0-2000 ppm sensor on ADC7 and should be replaced by the points from the
+// sensor's calibration sheet.
+//
+// Warnings             : none
+// Restrictions         : none
+// Algorithms           : Piecewise-linear interpolation in fixed point
+// References           : HumidIcon HIH6000 series data sheet
+//
+// Revision History     : Initial version
+//
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include "calibration.h"
+#include "ADC.h"
+
+//RH: (raw / (2^14 - 2)) * 100%, in units of 0.01 %RH
+const cal_segment __flash rh_segments[] = {
+//         RAW      CAL     RAW      CAL
+  CAL_SEG( 0,       0,      16382,   10000)
+};
+
+//Temperature: (raw / (2^14 - 2)) * 165 - 40, in units of 0.01 C
+const cal_segment __flash temp_segments[] = {
+//         RAW      CAL     RAW      CAL
+  CAL_SEG( 0,       -4000,  16382,   12500)
+};
+
+//CO2: oversampled ADC result to ppm. The points are given in 10 bit counts
+//and scaled to the result width by ADC_COUNTS. The sensor output starts at
+//0.4 V (82 counts) and the response flattens toward the top of its range.
+const cal_segment __flash co2_segments[] = {
+//         RAW                  CAL     RAW                     CAL
+  CAL_SEG( ADC_COUNTS(0),       0,      ADC_COUNTS(82),         0),
+  CAL_SEG( ADC_COUNTS(82),      0,      ADC_COUNTS(164),        560),
+  CAL_SEG( ADC_COUNTS(164),     560,    ADC_COUNTS(246),        1080),
+  CAL_SEG( ADC_COUNTS(246),     1080,   ADC_COUNTS(328),        1560),
+  CAL_SEG( ADC_COUNTS(328),     1560,   ADC_COUNTS(410),        2000),
+  CAL_SEG( ADC_COUNTS(410),     2000,   ADC_COUNTS(1023),       2000)
+};
+
+//Setup the array with all of the calibration tables, indexed by channel
+const cal_table __flash cal_tables[CAL_CHANNELS] = {
+  { rh_segments,        sizeof(rh_segments) / sizeof(cal_segment) },
+  { temp_segments,      sizeof(temp_segments) / sizeof(cal_segment) },
+  { co2_segments,       sizeof(co2_segments) / sizeof(cal_segment) }
+};
+
+//******************************************************************************
+// Function : int cal_convert(unsigned char channel, unsigned int raw)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Converts a raw reading into calibrated units using the table of the given
+// channel. A binary search finds the last segment starting at or below raw,
+// then the value is interpolated along that segment. Readings below the first
+// segment or above the last one are extrapolated along the end segments.
+// With the table in flash this costs a few LPM loads, one 16x16 multiply and
+// a constant shift.
+//
+//******************************************************************************
+int cal_convert(unsigned char channel, unsigned int raw){
+  const cal_segment __flash *seg = cal_tables[channel].seg;
+  unsigned char lo = 0;
+  unsigned char hi = cal_tables[channel].count;
+
+  //Narrow down to the segment that contains raw
+  while((unsigned char)(hi - lo) > 1){
+    unsigned char mid = (lo + hi) >> 1;
+    if(seg[mid].raw <= raw)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  seg += lo;
+
+  //Interpolate along the segment, rounding to the nearest unit
+  int dx = (int)(raw - seg->raw);
+  long offset = (long)dx * seg->slope + (1L << (CAL_SHIFT - 1));
+
+  return seg->cal + (int)(offset >> CAL_SHIFT);
+}
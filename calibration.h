@@ -0,0 +1,57 @@
+//***************************************************************************
+//
+// File Name            : calibration.h
+// Title                : Header file for sensor calibration module
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ;
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// This file includes all the declaration the compiler needs to
+// reference the functions and tables written in the file calibration.c
+//
+// Warnings             : none
+// Restrictions         : Raw values must stay below 32768 and segment slopes
+//                        must stay below 8 calibrated units per raw count
+// Algorithms           : Piecewise-linear interpolation in fixed point
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//**************************************************************************
+
+//Fixed-point scale of the segment slopes (Q4.12)
+#define CAL_SHIFT       12
+
+//Calibration channels. Each channel has its own table in flash.
+#define CAL_RH          0       //HumidIcon RH, result in 0.01 %RH
+#define CAL_TEMP        1       //HumidIcon temperature, result in 0.01 C
+#define CAL_CO2         2       //CO2 sensor on the ADC, result in ppm
+#define CAL_CHANNELS    3
+
+//One segment of a calibration curve. The segment starts at raw and has the
+//calibrated value cal there. slope is the change in calibrated units per raw
+//count, scaled by 2^CAL_SHIFT.
+typedef struct{
+  unsigned int raw;
+  int cal;
+  int slope;
+} cal_segment;
+
+//A calibration table is a list of segments sorted by raw start value
+typedef struct{
+  const cal_segment __flash *seg;
+  unsigned char count;
+} cal_table;
+
+//Builds a segment from its two end points (x0, y0) and (x1, y1). The slope is
+//computed and rounded by the compiler, so nothing is divided at run time.
+#define CAL_SEG(x0, y0, x1, y1) \
+  { (x0), (y0), (int)(((((long)(y1)) - (y0)) * (1L << CAL_SHIFT) + \
+    ((y1) >= (y0) ? ((x1) - (x0)) / 2 : -(((x1) - (x0)) / 2))) / \
+    ((long)(x1) - (x0))) }
+
+//These are the functions located in calibration.c
+extern int cal_convert(unsigned char channel, unsigned int raw);
@@ -0,0 +1,58 @@
+//***************************************************************************
+//
+// File Name            : event.h
+// Title                : Header file for the event queue and scheduler
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @  16MHz
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// This file includes all the declaration the compiler needs to 
+// reference the functions and variables written in the file event_queue.c
+//
+// Warnings             : event_post may only be called from an interrupt
+// Restrictions         : none
+// Algorithms           : Single-producer/single-consumer ring buffers
+// References           : none
+//
+// Revision History     : Initial version 
+// 
+//
+//**************************************************************************
+
+//Event types. Each type has a handler in event_handlers[] and a priority in
+//event_queue.c.
+#define EV_KEY          0       //Key events queued by the keypad scanner
+#define EV_TICK         1       //1Hz output of the RTC
+#define EV_ALARM        2       //Alarm0 of the RTC
+#define EV_COUNT        3
+
+//Priorities, one ring buffer each. Lower numbers are dispatched first.
+#define EV_PRIO_HIGH    0
+#define EV_PRIO_NORMAL  1
+#define EV_PRIO_LOW     2
+#define EV_PRIO_COUNT   3
+
+//An event as it sits in the queue
+typedef struct{
+  unsigned char type;
+  unsigned char arg;
+} event;
+
+//Pointer to an event handler
+typedef void (*event_fn_ptr) (unsigned char arg);
+
+//Handlers indexed by event type, provided by the application
+extern const event_fn_ptr __flash event_handlers[EV_COUNT];
+
+//Number of events dropped because their ring was full
+extern volatile unsigned char event_overflows;
+
+//Static SRAM of the event queue, for the SRAM budget
+extern const unsigned int __flash event_sram_bytes;
+
+//These are the functions located in event_queue.c
+extern void event_post(unsigned char type, unsigned char arg);
+extern unsigned char event_get(event *ev);
+extern void event_dispatch(void);
+extern unsigned char event_waiting(void);
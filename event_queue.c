@@ -0,0 +1,142 @@
+//******************************************************************************
+//
+// File Name            : event_queue.c
+// Title                : Event queue and run-to-completion scheduler
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ; 
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Interrupt service routines only record what happened by posting an event.
+// The events are queued in one ring buffer per priority, and main() takes
+// them out highest priority first and calls the handler of each one. A
+// handler runs to completion before the next event is looked at.
+//
+// Every ring has a single producer and a single consumer. The producers are
+// the interrupts, which do not nest, so only one of them posts at a time. The
+// consumer is main(). The producer only writes ev_head and the consumer only
+// writes ev_tail, and both are single bytes, so no locking is needed in
+// either direction.
+//
+// Warnings             : event_post may only be called from an interrupt
+// Restrictions         : none
+// Algorithms           : Single-producer/single-consumer ring buffers
+// References           : none
+//
+// Revision History     : Initial version 
+// 
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include "event.h"
+
+//Entries per ring, must be a power of two
+#define EV_RING_SIZE    16
+#define EV_RING_MASK    (EV_RING_SIZE - 1)
+
+//Priority of each event type
+const unsigned char __flash event_priority[EV_COUNT] = {
+  EV_PRIO_HIGH,         //EV_KEY
+  EV_PRIO_NORMAL,       //EV_TICK
+  EV_PRIO_HIGH          //EV_ALARM
+};
+
+//The rings. ev_head is the next entry to write, ev_tail the next to read.
+event ev_ring[EV_PRIO_COUNT][EV_RING_SIZE];
+volatile unsigned char ev_head[EV_PRIO_COUNT];
+volatile unsigned char ev_tail[EV_PRIO_COUNT];
+
+volatile unsigned char event_overflows;
+
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash event_sram_bytes =
+  sizeof(ev_ring) + sizeof(ev_head) + sizeof(ev_tail) + sizeof(event_overflows);
+
+//******************************************************************************
+// Function : void event_post(unsigned char type, unsigned char arg)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Queues an event on the ring of its priority. The entry is filled in before
+// ev_head moves past it, so main() never sees a half written event. If the
+// ring is full the event is dropped and counted in event_overflows.
+//
+//******************************************************************************
+void event_post(unsigned char type, unsigned char arg){
+  unsigned char prio = event_priority[type];
+  unsigned char head = ev_head[prio];
+
+  if((unsigned char)(head - ev_tail[prio]) == EV_RING_SIZE){
+    event_overflows++;
+    return;
+  }
+
+  ev_ring[prio][head & EV_RING_MASK].type = type;
+  ev_ring[prio][head & EV_RING_MASK].arg = arg;
+  ev_head[prio] = head + 1;
+}
+
+//******************************************************************************
+// Function : unsigned char event_get(event *ev)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Takes the oldest event of the highest priority ring that is not empty and
+// copies it to ev. Returns 0 if every ring is empty.
+//
+//******************************************************************************
+unsigned char event_get(event *ev){
+  for(unsigned char prio = 0; prio < EV_PRIO_COUNT; prio++){
+    unsigned char tail = ev_tail[prio];
+    if(tail != ev_head[prio]){
+      *ev = ev_ring[prio][tail & EV_RING_MASK];
+      ev_tail[prio] = tail + 1;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+//******************************************************************************
+// Function : unsigned char event_waiting(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns 1 if any ring holds an event, without taking it.
+//
+//******************************************************************************
+unsigned char event_waiting(void){
+  for(unsigned char prio = 0; prio < EV_PRIO_COUNT; prio++){
+    if(ev_tail[prio] != ev_head[prio])
+      return 1;
+  }
+  return 0;
+}
+
+//******************************************************************************
+// Function : void event_dispatch(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Runs the handler of the next event, if there is one. Called over and over
+// from the main loop, one event per call, so a higher priority event posted
+// while a handler runs is the next one dispatched.
+//
+//******************************************************************************
+void event_dispatch(void){
+  event ev;
+
+  if(event_get(&ev))
+    event_handlers[ev.type](ev.arg);
+}
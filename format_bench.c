@@ -0,0 +1,194 @@
+//******************************************************************************
+//
+// File Name            : format_bench.c
+// Title                : printf_P against the lcd_format formatters
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ;
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Times the fields of the idle and diagnostics pages written both ways, with
+// the printf_P and putchar path the display used to take and with the
+// formatters of lcd_format.c, and sends the cycles of each out of the serial
+// port as part of the diagnostics dump. Each field is timed with interrupts
+// off and the cost of reading the cycle counter taken off, so the numbers are
+// the formatting alone. The display buffer is put back afterwards.
+//
+// The flash the formatters save is read from the map file: build once with
+// FORMAT_BENCH commented out, where nothing links the printf engine, and
+// once with it defined, and compare the CODE size of the two maps. The
+// difference, less the few hundred bytes of this file, is the printf engine.
+//
+// Warnings             : Defining FORMAT_BENCH links printf_P, only define it
+//                        to take the measurement
+// Restrictions         : none
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include <avr_macros.h>
+#include "profile.h"
+
+#ifdef FORMAT_BENCH
+
+#include <stdio.h>
+#include <pgmspace.h>
+#include "lcd.h"
+#include "uart.h"
+
+//Fields timed, as the pages wrote them before lcd_format.c
+#define BENCH_TIME      0       //Time line of the idle pages
+#define BENCH_CENTI     1       //Temperature in hundredths
+#define BENCH_CO2       2       //CO2 line
+#define BENCH_FRAME     3       //Frame time of the profile page
+#define BENCH_FIELDS    4
+
+//Format strings of the printf_P path
+const char __flash bench_fmt_time[] = "Time: %d%d:%d%d:%d%d\n";
+const char __flash bench_fmt_centi[] = "%d.%02d";
+const char __flash bench_fmt_co2[] = "CO2 ppm:  %d\n";
+const char __flash bench_fmt_frame[] = "Frame %lu us";
+
+//Labels of the formatter path
+const char __flash bench_str_time[] = "Time: ";
+const char __flash bench_str_co2[] = "CO2 ppm:  ";
+const char __flash bench_str_frame[] = "Frame ";
+const char __flash bench_str_us[] = " us";
+
+//Text of the report, kept in flash
+const char __flash str_bench_header[] = "# format cycles printf_P lcd_put";
+const char __flash str_bench_time[] = "time ";
+const char __flash str_bench_centi[] = "centi ";
+const char __flash str_bench_co2[] = "co2 ";
+const char __flash str_bench_frame[] = "frame ";
+
+const char __flash * const __flash str_bench_fields[BENCH_FIELDS] = {
+  str_bench_time, str_bench_centi, str_bench_co2, str_bench_frame
+};
+
+//Values written, about what the pages show
+#define BENCH_HOURS     12
+#define BENCH_MINUTES   34
+#define BENCH_SECONDS   56
+#define BENCH_TEMP      2345            //23.45 C
+#define BENCH_CO2_PPM   1234
+#define BENCH_FRAME_US  12345UL
+
+//******************************************************************************
+// Function : unsigned long bench_cycles(unsigned long start,
+//                                       unsigned long overhead)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns the cycles since start less the cost of reading the counter.
+//
+//******************************************************************************
+unsigned long bench_cycles(unsigned long start, unsigned long overhead){
+  return cycles_now() - start - overhead;
+}
+
+//******************************************************************************
+// Function : void format_bench(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Writes each field both ways into the display buffer, timing both, and
+// sends the cycles out of the serial port.
+//
+//******************************************************************************
+void format_bench(void){
+  unsigned long printf_cycles[BENCH_FIELDS];
+  unsigned long put_cycles[BENCH_FIELDS];
+  char saved[LCD_CELLS];
+  unsigned long start;
+  char *p;
+
+  for(unsigned char i = 0; i < LCD_CELLS; i++)
+    saved[i] = dsp_buff[i];
+
+  __istate_t state = __get_interrupt_state();
+  __disable_interrupt();
+
+  //Cost of reading the counter, taken off every measurement
+  start = cycles_now();
+  unsigned long overhead = cycles_now() - start;
+
+  //Time line
+  clear_dsp();
+  start = cycles_now();
+  printf_P(bench_fmt_time, BENCH_HOURS / 10, BENCH_HOURS % 10,
+           BENCH_MINUTES / 10, BENCH_MINUTES % 10,
+           BENCH_SECONDS / 10, BENCH_SECONDS % 10);
+  printf_cycles[BENCH_TIME] = bench_cycles(start, overhead);
+
+  start = cycles_now();
+  p = lcd_put_P(lcd_at(0, 0), bench_str_time);
+  p = lcd_put_2d(p, BENCH_HOURS);
+  *p++ = ':';
+  p = lcd_put_2d(p, BENCH_MINUTES);
+  *p++ = ':';
+  lcd_put_2d(p, BENCH_SECONDS);
+  put_cycles[BENCH_TIME] = bench_cycles(start, overhead);
+
+  //Value in hundredths
+  clear_dsp();
+  start = cycles_now();
+  printf_P(bench_fmt_centi, BENCH_TEMP / 100, BENCH_TEMP % 100);
+  printf_cycles[BENCH_CENTI] = bench_cycles(start, overhead);
+
+  start = cycles_now();
+  lcd_put_centi(lcd_at(0, 0), BENCH_TEMP);
+  put_cycles[BENCH_CENTI] = bench_cycles(start, overhead);
+
+  //CO2 line
+  clear_dsp();
+  start = cycles_now();
+  printf_P(bench_fmt_co2, BENCH_CO2_PPM);
+  printf_cycles[BENCH_CO2] = bench_cycles(start, overhead);
+
+  start = cycles_now();
+  p = lcd_put_P(lcd_at(0, 0), bench_str_co2);
+  lcd_put_int(p, BENCH_CO2_PPM, 0);
+  put_cycles[BENCH_CO2] = bench_cycles(start, overhead);
+
+  //Frame time, a 32 bit value
+  clear_dsp();
+  start = cycles_now();
+  printf_P(bench_fmt_frame, BENCH_FRAME_US);
+  printf_cycles[BENCH_FRAME] = bench_cycles(start, overhead);
+
+  start = cycles_now();
+  p = lcd_put_P(lcd_at(0, 0), bench_str_frame);
+  p = lcd_put_ulong(p, BENCH_FRAME_US, 0);
+  lcd_put_P(p, bench_str_us);
+  put_cycles[BENCH_FRAME] = bench_cycles(start, overhead);
+
+  __set_interrupt_state(state);
+
+  clear_dsp();
+  for(unsigned char i = 0; i < LCD_CELLS; i++)
+    dsp_buff[i] = saved[i];
+
+  uart_puts_P(str_bench_header);
+  uart_newline();
+  for(unsigned char i = 0; i < BENCH_FIELDS; i++){
+    uart_puts_P(str_bench_fields[i]);
+    uart_put_uint(printf_cycles[i] > 0xFFFF ? 0xFFFF : printf_cycles[i]);
+    uart_putc(' ');
+    uart_put_uint(put_cycles[i] > 0xFFFF ? 0xFFFF : put_cycles[i]);
+    uart_newline();
+  }
+}
+
+#endif
@@ -9,8 +9,8 @@
 // Author               : Augusto Celis / Michael Anderson
 // DESCRIPTION
 // This file includes all the declaration the compiler needs to 
-// reference the functions and variables written in the files fsm_table.c
-// and fsm_ui.c
+// reference the functions and variables written in the files fsm_table.c,
+// fsm_dense.c, fsm_trace.c and fsm_ui.c
 //
 // Warnings             : none
 // Restrictions         : none
@@ -22,6 +22,8 @@
 //
 //**************************************************************************
 
+#define FSM_TRACE   //comment out to compile the transition trace out
+
 //This will be the enum for the state variable and key variable
 typedef enum { idle_dsp, options, set_time, choose_time_alarm, 
 show_alarm_setting, show_instr} state;
@@ -43,7 +45,7 @@ extern unsigned char keyConversion;
 extern void dsp_options_screen();
 extern void dsp_instr_screen();
 extern void toggle_alarm_enable(); //Print and enable
-extern void dsp_time_temp_rh();
+extern void dsp_idle_page();
 extern void dsp_set_time();
 extern void dsp_time_alarm_choice();
 extern void set_system_time();
@@ -53,4 +55,29 @@ extern void invalid_time_entry();
 extern void invalid_time_alarm_choice();
 extern void invalid_key();
 extern void scroll_dsp_down();
-extern void scroll_dsp_up();
\ No newline at end of file
+extern void scroll_dsp_up();
+extern void dump_diagnostics();
+
+#ifdef FSM_TRACE
+//Number of fsm calls kept in the trace
+#define FSM_TRACE_SIZE 16
+
+//One fsm call as recorded in the trace
+typedef struct{
+  unsigned long time;           //sys_ticks when the key was handled
+  unsigned long cycles;         //CPU cycles spent in the task
+  unsigned char state;          //Present state
+  unsigned char key;
+  unsigned char row;            //Row of the transition table that matched
+  unsigned char next_state;
+} fsm_trace_entry;
+
+//Static SRAM of the trace, for the SRAM budget
+extern const unsigned int __flash fsm_trace_sram_bytes;
+
+//These are the functions located in fsm_trace.c
+extern void fsm_trace_record(state ps, key keyval, unsigned char row,
+                             state next, unsigned long cycles);
+extern unsigned char fsm_trace_get(unsigned char age, fsm_trace_entry *entry);
+extern void fsm_trace_dump(void);
+#endif
\ No newline at end of file
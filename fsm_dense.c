@@ -0,0 +1,211 @@
+//******************************************************************************
+//
+// File Name            : fsm_dense.c
+// Title                : Dense FSM transition table
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ;
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// GENERATED BY fsm_gen.py FROM fsm_table.c, DO NOT EDIT. Edit the sparse
+// tables in fsm_table.c and run fsm_gen.py again.
+//
+// Every state has a row with a cell for every key, giving the next state, the
+// index of the task in fsm_tasks and the row of the sparse table in
+// fsm_table.c the cell was made from. Both tables are in flash.
+//
+// Warnings             : none
+// Restrictions         : Not used when FSM_LINEAR_SCAN is defined
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include <avr_macros.h>
+#include "fsm.h"
+#include "profile.h"
+
+#ifndef FSM_LINEAR_SCAN
+
+//Pointer to task function
+typedef void (*task_fn_ptr) ();
+
+//One cell of the table
+typedef struct{
+  unsigned char next_state;
+  unsigned char task;
+  unsigned char row;
+} fsm_cell;
+
+//Tasks, indexed by fsm_cell.task
+const task_fn_ptr __flash fsm_tasks[14] = {
+  dsp_options_screen,
+  dsp_instr_screen,
+  scroll_dsp_up,
+  scroll_dsp_down,
+  invalid_key,
+  dsp_enter_time,
+  toggle_alarm_enable,
+  dsp_set_time,
+  dsp_time_alarm_choice,
+  invalid_time_entry,
+  set_system_time,
+  set_system_alarm,
+  invalid_time_alarm_choice,
+  dsp_idle_page
+};
+
+//Transitions, indexed by state and key
+const fsm_cell __flash fsm_table[6][16] = {
+  //idle_dsp
+  {
+    { idle_dsp,            4,  4 },  //one (eol)
+    { idle_dsp,            4,  4 },  //two (eol)
+    { idle_dsp,            4,  4 },  //three (eol)
+    { idle_dsp,            2,  2 },  //up
+    { idle_dsp,            4,  4 },  //four (eol)
+    { idle_dsp,            4,  4 },  //five (eol)
+    { idle_dsp,            4,  4 },  //six (eol)
+    { idle_dsp,            3,  3 },  //down
+    { idle_dsp,            4,  4 },  //seven (eol)
+    { idle_dsp,            4,  4 },  //eight (eol)
+    { idle_dsp,            4,  4 },  //nine (eol)
+    { options,             0,  0 },  //second
+    { idle_dsp,            4,  4 },  //clear (eol)
+    { idle_dsp,            4,  4 },  //zero (eol)
+    { show_instr,          1,  1 },  //help
+    { idle_dsp,            4,  4 }   //enter (eol)
+  },
+  //options
+  {
+    { set_time,            5,  0 },  //one
+    { show_alarm_setting,  6,  1 },  //two
+    { idle_dsp,            4,  2 },  //three (eol)
+    { idle_dsp,            4,  2 },  //up (eol)
+    { idle_dsp,            4,  2 },  //four (eol)
+    { idle_dsp,            4,  2 },  //five (eol)
+    { idle_dsp,            4,  2 },  //six (eol)
+    { idle_dsp,            4,  2 },  //down (eol)
+    { idle_dsp,            4,  2 },  //seven (eol)
+    { idle_dsp,            4,  2 },  //eight (eol)
+    { idle_dsp,            4,  2 },  //nine (eol)
+    { idle_dsp,            4,  2 },  //second (eol)
+    { idle_dsp,            4,  2 },  //clear (eol)
+    { idle_dsp,            4,  2 },  //zero (eol)
+    { idle_dsp,            4,  2 },  //help (eol)
+    { idle_dsp,            4,  2 }   //enter (eol)
+  },
+  //set_time
+  {
+    { set_time,            7,  1 },  //one
+    { set_time,            7,  2 },  //two
+    { set_time,            7,  3 },  //three
+    { set_time,            9, 11 },  //up (eol)
+    { set_time,            7,  4 },  //four
+    { set_time,            7,  5 },  //five
+    { set_time,            7,  6 },  //six
+    { set_time,            9, 11 },  //down (eol)
+    { set_time,            7,  7 },  //seven
+    { set_time,            7,  8 },  //eight
+    { set_time,            7,  9 },  //nine
+    { set_time,            9, 11 },  //second (eol)
+    { set_time,            9, 11 },  //clear (eol)
+    { set_time,            7,  0 },  //zero
+    { set_time,            9, 11 },  //help (eol)
+    { choose_time_alarm,   8, 10 }   //enter
+  },
+  //choose_time_alarm
+  {
+    { idle_dsp,           10,  0 },  //one
+    { idle_dsp,           11,  1 },  //two
+    { choose_time_alarm,  12,  2 },  //three (eol)
+    { choose_time_alarm,  12,  2 },  //up (eol)
+    { choose_time_alarm,  12,  2 },  //four (eol)
+    { choose_time_alarm,  12,  2 },  //five (eol)
+    { choose_time_alarm,  12,  2 },  //six (eol)
+    { choose_time_alarm,  12,  2 },  //down (eol)
+    { choose_time_alarm,  12,  2 },  //seven (eol)
+    { choose_time_alarm,  12,  2 },  //eight (eol)
+    { choose_time_alarm,  12,  2 },  //nine (eol)
+    { choose_time_alarm,  12,  2 },  //second (eol)
+    { choose_time_alarm,  12,  2 },  //clear (eol)
+    { choose_time_alarm,  12,  2 },  //zero (eol)
+    { choose_time_alarm,  12,  2 },  //help (eol)
+    { choose_time_alarm,  12,  2 }   //enter (eol)
+  },
+  //show_alarm_setting
+  {
+    { idle_dsp,           13,  0 },  //one (eol)
+    { idle_dsp,           13,  0 },  //two (eol)
+    { idle_dsp,           13,  0 },  //three (eol)
+    { idle_dsp,           13,  0 },  //up (eol)
+    { idle_dsp,           13,  0 },  //four (eol)
+    { idle_dsp,           13,  0 },  //five (eol)
+    { idle_dsp,           13,  0 },  //six (eol)
+    { idle_dsp,           13,  0 },  //down (eol)
+    { idle_dsp,           13,  0 },  //seven (eol)
+    { idle_dsp,           13,  0 },  //eight (eol)
+    { idle_dsp,           13,  0 },  //nine (eol)
+    { idle_dsp,           13,  0 },  //second (eol)
+    { idle_dsp,           13,  0 },  //clear (eol)
+    { idle_dsp,           13,  0 },  //zero (eol)
+    { idle_dsp,           13,  0 },  //help (eol)
+    { idle_dsp,           13,  0 }   //enter (eol)
+  },
+  //show_instr
+  {
+    { idle_dsp,           13,  0 },  //one (eol)
+    { idle_dsp,           13,  0 },  //two (eol)
+    { idle_dsp,           13,  0 },  //three (eol)
+    { idle_dsp,           13,  0 },  //up (eol)
+    { idle_dsp,           13,  0 },  //four (eol)
+    { idle_dsp,           13,  0 },  //five (eol)
+    { idle_dsp,           13,  0 },  //six (eol)
+    { idle_dsp,           13,  0 },  //down (eol)
+    { idle_dsp,           13,  0 },  //seven (eol)
+    { idle_dsp,           13,  0 },  //eight (eol)
+    { idle_dsp,           13,  0 },  //nine (eol)
+    { idle_dsp,           13,  0 },  //second (eol)
+    { idle_dsp,           13,  0 },  //clear (eol)
+    { idle_dsp,           13,  0 },  //zero (eol)
+    { idle_dsp,           13,  0 },  //help (eol)
+    { idle_dsp,           13,  0 }   //enter (eol)
+  }
+};
+
+//******************************************************************************
+// Function : void fsm(state ps, key keyval)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Looks up the cell of the present state and key, runs its task and sets up
+// the present state as the next state of the FSM. The call is recorded in the
+// trace when FSM_TRACE is defined.
+//
+//******************************************************************************
+void fsm(state ps, key keyval){
+  fsm_cell cell = fsm_table[ps][keyval];
+
+#ifdef FSM_TRACE
+  unsigned long start = cycles_now();
+#endif
+
+  fsm_tasks[cell.task]();
+
+#ifdef FSM_TRACE
+  fsm_trace_record(ps, keyval, cell.row, (state)cell.next_state,
+                   cycles_now() - start);
+#endif
+
+  present_state = (state)cell.next_state;
+}
+
+#endif
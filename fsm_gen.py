@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+#******************************************************************************
+#
+# File Name            : fsm_gen.py
+# Title                : Dense FSM table generator
+# Date                 : 10/19/26
+# Version              : 1.0
+# Target MCU           : ATmega128 @ 16MHz
+# Author               : Augusto Celis / Michael Anderson
+# DESCRIPTION
+# Reads the state and key enums from fsm.h and the sparse transition tables
+# from fsm_table.c, checks them, and writes fsm_dense.c. fsm_dense.c holds a
+# [state][key] table in flash with the next state and task of every pair,
+# filled in from the eol row of the state for keys without their own row, so
+# fsm() is a single indexed load whatever the size of the tables. Each cell
+# also keeps the row of the sparse table it came from for the FSM trace.
+#
+# The tables are checked for
+#   - a state without a table, or a table that does not end in an eol row
+#   - a key listed twice in one table, or listed after the eol row
+#   - a state, key or task name that is not declared
+#   - a state that cannot be reached from idle_dsp
+# and no file is written if any check fails.
+#
+# Run it from the project directory after editing fsm_table.c or fsm.h, and
+# before building:
+#   python3 fsm_gen.py
+#
+# Warnings             : The sparse tables must keep the layout of
+#                        fsm_table.c, one { key, state, task } row per line
+# Restrictions         : none
+# Algorithms           : none
+# References           : none
+#
+# Revision History     : Initial version
+#
+#
+#******************************************************************************
+
+import re
+import sys
+
+HEADER = "fsm.h"
+TABLES = "fsm_table.c"
+OUTPUT = "fsm_dense.c"
+INITIAL_STATE = "idle_dsp"
+
+
+def read(name):
+    with open(name) as f:
+        return f.read()
+
+
+def parse_enum(text, type_name):
+    m = re.search(r"typedef\s+enum\s*\{([^}]*)\}\s*" + type_name + r"\s*;",
+                  text)
+    if not m:
+        sys.exit("%s: enum %s not found" % (HEADER, type_name))
+    body = re.sub(r"//.*", "", m.group(1))
+    return [n.strip() for n in body.split(",") if n.strip()]
+
+
+def parse_tasks(text):
+    return re.findall(r"extern\s+void\s+(\w+)\s*\(", text)
+
+
+def parse_tables(text):
+    tables = {}
+    for m in re.finditer(r"const\s+transition\s+(?:__flash\s+)?"
+                         r"(\w+)_transitions\s*\[\s*\]"
+                         r"\s*=\s*\{(.*?)\n\};", text, re.S):
+        body = re.sub(r"//.*", "", m.group(2))
+        rows = re.findall(r"\{\s*(\w+)\s*,\s*(\w+)\s*,\s*(\w+)\s*\}", body)
+        tables[m.group(1)] = rows
+    return tables
+
+
+def check(states, keys, tasks, tables):
+    errors = []
+    for s in states:
+        if s not in tables:
+            errors.append("state %s has no transition table" % s)
+    for name, rows in tables.items():
+        if name not in states:
+            errors.append("table %s_transitions is not a state" % name)
+        seen = set()
+        ended = False
+        for key, nxt, task in rows:
+            if ended:
+                errors.append("%s: row for %s after eol can never match"
+                              % (name, key))
+            if key not in keys:
+                errors.append("%s: unknown key %s" % (name, key))
+            if nxt not in states:
+                errors.append("%s: unknown state %s" % (name, nxt))
+            if task not in tasks:
+                errors.append("%s: undeclared task %s" % (name, task))
+            if key in seen:
+                errors.append("%s: key %s listed twice" % (name, key))
+            seen.add(key)
+            if key == "eol":
+                ended = True
+        if not ended:
+            errors.append("%s: no eol row for the default transition" % name)
+    if errors:
+        return errors
+
+    reached = {INITIAL_STATE}
+    todo = [INITIAL_STATE]
+    while todo:
+        for key, nxt, task in tables[todo.pop()]:
+            if nxt not in reached:
+                reached.add(nxt)
+                todo.append(nxt)
+    for s in states:
+        if s not in reached:
+            errors.append("state %s cannot be reached from %s"
+                          % (s, INITIAL_STATE))
+    return errors
+
+
+def generate(states, keys, tables):
+    inputs = [k for k in keys if k != "eol"]
+    tasks = []
+    for s in states:
+        for key, nxt, task in tables[s]:
+            if task not in tasks:
+                tasks.append(task)
+
+    out = []
+    out.append("""//******************************************************************************
+//
+// File Name            : fsm_dense.c
+// Title                : Dense FSM transition table
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ;
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// GENERATED BY fsm_gen.py FROM fsm_table.c, DO NOT EDIT. Edit the sparse
+// tables in fsm_table.c and run fsm_gen.py again.
+//
+// Every state has a row with a cell for every key, giving the next state, the
+// index of the task in fsm_tasks and the row of the sparse table in
+// fsm_table.c the cell was made from. Both tables are in flash.
+//
+// Warnings             : none
+// Restrictions         : Not used when FSM_LINEAR_SCAN is defined
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include <avr_macros.h>
+#include "fsm.h"
+#include "profile.h"
+
+#ifndef FSM_LINEAR_SCAN
+
+//Pointer to task function
+typedef void (*task_fn_ptr) ();
+
+//One cell of the table
+typedef struct{
+  unsigned char next_state;
+  unsigned char task;
+  unsigned char row;
+} fsm_cell;
+
+//Tasks, indexed by fsm_cell.task
+""")
+    out.append("const task_fn_ptr __flash fsm_tasks[%d] = {\n" % len(tasks))
+    out.append(",\n".join("  %s" % t for t in tasks))
+    out.append("\n};\n\n")
+
+    width = max(len(s) for s in states)
+    out.append("//Transitions, indexed by state and key\n")
+    out.append("const fsm_cell __flash fsm_table[%d][%d] = {\n"
+               % (len(states), len(inputs)))
+    blocks = []
+    for s in states:
+        rows = tables[s]
+        default = [r for r in rows if r[0] == "eol"][0]
+        by_key = dict((r[0], r) for r in rows)
+        cells = []
+        for i, k in enumerate(inputs):
+            row = by_key.get(k, default)
+            key, nxt, task = row
+            comma = "," if i < len(inputs) - 1 else " "
+            cells.append("    { %-*s %2d, %2d }%s  //%s%s"
+                         % (width + 1, nxt + ",", tasks.index(task),
+                            rows.index(row), comma,
+                            k, "" if k in by_key else " (eol)"))
+        blocks.append("  //%s\n  {\n%s\n  }" % (s, "\n".join(cells)))
+    out.append(",\n".join(blocks))
+    out.append("\n};\n")
+
+    out.append("""
+//******************************************************************************
+// Function : void fsm(state ps, key keyval)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Looks up the cell of the present state and key, runs its task and sets up
+// the present state as the next state of the FSM. The call is recorded in the
+// trace when FSM_TRACE is defined.
+//
+//******************************************************************************
+void fsm(state ps, key keyval){
+  fsm_cell cell = fsm_table[ps][keyval];
+
+#ifdef FSM_TRACE
+  unsigned long start = cycles_now();
+#endif
+
+  fsm_tasks[cell.task]();
+
+#ifdef FSM_TRACE
+  fsm_trace_record(ps, keyval, cell.row, (state)cell.next_state,
+                   cycles_now() - start);
+#endif
+
+  present_state = (state)cell.next_state;
+}
+
+#endif
+""")
+    return "".join(out)
+
+
+def main():
+    header = read(HEADER)
+    states = parse_enum(header, "state")
+    keys = parse_enum(header, "key")
+    tasks = parse_tasks(header)
+    tables = parse_tables(read(TABLES))
+
+    errors = check(states, keys, tasks, tables)
+    if errors:
+        for e in errors:
+            print("%s: %s" % (TABLES, e), file=sys.stderr)
+        sys.exit(1)
+
+    with open(OUTPUT, "w") as f:
+        f.write(generate(states, keys, tables))
+    print("%s: %d states x %d keys" % (OUTPUT, len(states), len(keys) - 1))
+
+
+if __name__ == "__main__":
+    main()
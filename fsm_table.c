@@ -2,10 +2,18 @@
 #include <intrinsics.h>
 #include <avr_macros.h>
 #include "fsm.h"
+#include "profile.h"
+
+//#define FSM_LINEAR_SCAN   //uncomment to search the tables below at run time
+                            //instead of using the table in fsm_dense.c
 
 //Global variable for present state of the FSM
 state present_state;
 
+//The tables below are the source for fsm_dense.c. Run fsm_gen.py after
+//changing them, it checks them and builds the dense table from them.
+#ifdef FSM_LINEAR_SCAN
+
 //Pointer to task function
 typedef void (*task_fn_ptr) ();
 
@@ -17,7 +25,7 @@ typedef struct{
 } transition;
 
 //Transition table for idle_dsp state
-const transition idle_dsp_transitions[] = {
+const transition __flash idle_dsp_transitions[] = {
 //  INPUT       NEXT_STATE      TASK
   { second,     options,        dsp_options_screen},
   { help,       show_instr,     dsp_instr_screen},
@@ -27,14 +35,14 @@ const transition idle_dsp_transitions[] = {
 };
   
 //Transition table for options state
-const transition options_transitions[] = {
+const transition __flash options_transitions[] = {
 //  INPUT       NEXT_STATE      TASK
   { one,        set_time,       dsp_enter_time},
   { two,        show_alarm_setting,     toggle_alarm_enable},
   { eol,        idle_dsp,       invalid_key}
 };
 
-const transition set_time_transitions[] = {
+const transition __flash set_time_transitions[] = {
   { zero,        set_time,              dsp_set_time},
   { one,        set_time,              dsp_set_time},
   { two,        set_time,              dsp_set_time},
@@ -50,7 +58,7 @@ const transition set_time_transitions[] = {
 };
 
 //Transition table for choose_time_alarm state
-const transition choose_time_alarm_transitions[] = {
+const transition __flash choose_time_alarm_transitions[] = {
   //  INPUT       NEXT_STATE      TASK
   { one,        idle_dsp,       set_system_time},
   { two,        idle_dsp,       set_system_alarm},
@@ -58,19 +66,19 @@ const transition choose_time_alarm_transitions[] = {
 };
 
 //Transition table for show_alarm_setting state
-const transition show_alarm_setting_transitions[] = {
+const transition __flash show_alarm_setting_transitions[] = {
 //  INPUT       NEXT_STATE      TASK
-  { eol,        idle_dsp,       dsp_time_temp_rh}
+  { eol,        idle_dsp,       dsp_idle_page}
 };
 
 //Transition table for show_instr state
-const transition show_instr_transitions[] = {
+const transition __flash show_instr_transitions[] = {
 //  INPUT       NEXT_STATE      TASK
-  { eol,        idle_dsp,       dsp_time_temp_rh}
+  { eol,        idle_dsp,       dsp_idle_page}
 };
 
 //Setup the array with all of the transitions
-const transition *ps_transitions_ptr [6] = {
+const transition __flash * const __flash ps_transitions_ptr [6] = {
   idle_dsp_transitions,
   options_transitions,
   set_time_transitions,
@@ -100,7 +108,18 @@ void fsm(state ps, key keyval){
   for(i = 0; (ps_transitions_ptr[ps][i].keyval != keyval)
      && (ps_transitions_ptr[ps][i].keyval != eol); i++);
   
+#ifdef FSM_TRACE
+  unsigned long start = cycles_now();
+#endif
+  
   ps_transitions_ptr[ps][i].tf_ptr();
   
+#ifdef FSM_TRACE
+  fsm_trace_record(ps, keyval, i, ps_transitions_ptr[ps][i].next_state,
+                   cycles_now() - start);
+#endif
+  
   present_state = ps_transitions_ptr[ps][i].next_state;
-}
\ No newline at end of file
+}
+
+#endif
\ No newline at end of file
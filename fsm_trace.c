@@ -0,0 +1,140 @@
+//******************************************************************************
+//
+// File Name            : fsm_trace.c
+// Title                : FSM transition trace
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ; 
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Keeps the last FSM_TRACE_SIZE calls of fsm() in a ring buffer: when the key
+// was handled, the present state, the key, the row of the transition table
+// that matched, the next state and the CPU cycles spent in the task. The
+// trace can be sent out of the serial port with fsm_trace_dump, and the
+// entries can be read one at a time for the diagnostics page.
+//
+// fsm() only runs from main(), so the ring needs no locking. Recording costs
+// two cycle counter reads and a 12 byte copy per key.
+//
+// Warnings             : none
+// Restrictions         : Only built when FSM_TRACE is defined in fsm.h
+// Algorithms           : Ring buffer
+// References           : none
+//
+// Revision History     : Initial version 
+// 
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include <avr_macros.h>
+#include "fsm.h"
+#include "timer.h"
+#include "uart.h"
+
+#ifdef FSM_TRACE
+
+//The ring and the number of fsm calls recorded since reset. The next entry
+//to write is fsm_trace_count modulo FSM_TRACE_SIZE.
+fsm_trace_entry fsm_trace[FSM_TRACE_SIZE];
+unsigned int fsm_trace_count;
+
+//Header lines of the dump, kept in flash
+const char __flash str_trace_calls[] = "# fsm trace, calls ";
+const char __flash str_trace_columns[] = "# ms state key row next cycles";
+
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash fsm_trace_sram_bytes =
+  sizeof(fsm_trace) + sizeof(fsm_trace_count);
+
+//******************************************************************************
+// Function : void fsm_trace_record(state ps, key keyval, unsigned char row,
+//                                  state next, unsigned long cycles)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Called by fsm() after the task has run, writes over the oldest entry.
+//
+//******************************************************************************
+void fsm_trace_record(state ps, key keyval, unsigned char row, state next,
+                      unsigned long cycles){
+  fsm_trace_entry *entry = &fsm_trace[fsm_trace_count % FSM_TRACE_SIZE];
+
+  entry->time = timer_now();
+  entry->cycles = cycles;
+  entry->state = ps;
+  entry->key = keyval;
+  entry->row = row;
+  entry->next_state = next;
+
+  fsm_trace_count++;
+}
+
+//******************************************************************************
+// Function : unsigned char fsm_trace_get(unsigned char age,
+//                                        fsm_trace_entry *entry)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Copies an entry to entry, age 0 being the latest fsm call. Returns 0 if
+// there is no entry that old.
+//
+//******************************************************************************
+unsigned char fsm_trace_get(unsigned char age, fsm_trace_entry *entry){
+  if(age >= FSM_TRACE_SIZE || age >= fsm_trace_count)
+    return 0;
+
+  *entry = fsm_trace[(fsm_trace_count - 1 - age) % FSM_TRACE_SIZE];
+  return 1;
+}
+
+//******************************************************************************
+// Function : void fsm_trace_dump(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sends the trace out of the serial port, oldest entry first. Every line
+// holds the time in ms, state, key, row, next state and task cycles, the
+// time and cycles in hex.
+//
+//******************************************************************************
+void fsm_trace_dump(void){
+  fsm_trace_entry entry;
+  unsigned char age = FSM_TRACE_SIZE;
+
+  uart_puts_P(str_trace_calls);
+  uart_put_uint(fsm_trace_count);
+  uart_newline();
+  uart_puts_P(str_trace_columns);
+  uart_newline();
+
+  while(age--){
+    if(!fsm_trace_get(age, &entry))
+      continue;
+
+    uart_put_hex(entry.time >> 16);
+    uart_put_hex(entry.time);
+    uart_putc(' ');
+    uart_put_uint(entry.state);
+    uart_putc(' ');
+    uart_put_uint(entry.key);
+    uart_putc(' ');
+    uart_put_uint(entry.row);
+    uart_putc(' ');
+    uart_put_uint(entry.next_state);
+    uart_putc(' ');
+    uart_put_hex(entry.cycles >> 16);
+    uart_put_hex(entry.cycles);
+    uart_newline();
+  }
+}
+
+#endif
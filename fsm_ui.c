@@ -1,4 +1,3 @@
-#include <stdio.h>
 #include <iom128.h>
 #include <intrinsics.h>
 #include <avr_macros.h>
@@ -7,75 +6,184 @@
 #include "adc.h"
 #include "keypad.h"
 #include "DS1306_RTC.h"
+#include "calibration.h"
+#include "timer.h"
+#include "event.h"
+#include "profile.h"
+#include "uart.h"
+#include "stack.h"
+#include "ui_strings.h"
+#include "trend.h"
+#include "overlay.h"
+#include "alarm.h"
+#include "power.h"
 #include "fsm.h"
 
-// PAGE_COUNT needs to be updated any time a new device is connected which
-// requires a new page to display the information.
-#define PAGE_COUNT 2
+// Time between the samples of the trend pages, 32 samples cover 16 minutes
+#define TREND_PERIOD_MS 30000
+
+// Data sources a page reads that are only kept up to date while the page is
+// on the display: the time is read from the RTC just before the page is
+// drawn and the HumidIcon is only measured every second while the page needs
+// it. The ADC scan and the trend history are always kept up, trend_timer
+// needs both whatever page is shown, so they have no flag.
+#define PAGE_SRC_RTC            0x01
+#define PAGE_SRC_HUMIDICON      0x02
+
+// idle_pages needs to be updated any time a new device is connected which
+// requires a new page to display the information. Each page gives the
+// function that draws it, the PAGE_SRC_xxx sources it needs and how many
+// seconds go by between redraws. The diagnostics pages come last when they
+// are built in. PAGE_COUNT follows the table.
+void dsp_time_temp_rh();
+void dsp_time_co2();
+void dsp_trend_temp();
+void dsp_trend_rh();
+void dsp_trend_co2();
+void dsp_fsm_trace();
+void dsp_isr_profile();
+
+typedef void (*page_fn_ptr) ();
+
+typedef struct{
+  page_fn_ptr render;
+  unsigned char sources;        // PAGE_SRC_xxx the page needs
+  unsigned char refresh_s;      // Seconds between redraws
+} idle_page;
+
+const idle_page __flash idle_pages[] = {
+  {dsp_time_temp_rh,    PAGE_SRC_RTC | PAGE_SRC_HUMIDICON,      1},
+  {dsp_time_co2,        PAGE_SRC_RTC,                           1},
+  {dsp_trend_temp,      0,                      TREND_PERIOD_MS / 1000},
+  {dsp_trend_rh,        0,                      TREND_PERIOD_MS / 1000},
+  {dsp_trend_co2,       0,                      TREND_PERIOD_MS / 1000},
+#ifdef FSM_TRACE
+  {dsp_fsm_trace,       0,                      1},
+#endif
+#ifdef ISR_PROFILE
+  {dsp_isr_profile,     0,                      1},
+#endif
+};
+
+#define PAGE_COUNT (sizeof(idle_pages) / sizeof(idle_pages[0]))
 
 // page_index is used to keep track of the current idle display page
 int page_index = 0;
 
-// After an ADC conversion, the value is stored in adc_value
-int adc_value = 0;
+// Seconds since the page was drawn, and whether something else has been on
+// the display since
+unsigned char page_age;
+unsigned char page_stale;
 
 // keyConversion is used to store the converted value of the keypad
 unsigned char keyConversion;
 
+// Beep pattern played on the alarm output and how many times, see alarm.h
+#define ALARM_PATTERN   alarm_triple
+#define ALARM_PLAYS     3
+
+// Time an error message stays up, in ms
+#define MESSAGE_MS      2000
+
+// Room left for the numbers of the diagnostics pages once the label and the
+// unit are on the line: "Task " " cyc", "At " " ms" and "Frame " " us"
+#define TRACE_CYCLE_DIGITS      (LCD_COLUMNS - 5 - 4)
+#define TRACE_TIME_DIGITS       (LCD_COLUMNS - 3 - 3)
+#define FRAME_US_DIGITS         (LCD_COLUMNS - 6 - 3)
+
+// Time from the start of main to the first frame on the LCD, in us
+unsigned long boot_frame_us;
+
+const char __flash str_boot_header[] = "# boot to first frame";
+const char __flash str_boot_ms[] = " ms";
+
+// Software timers used by the user interface
+sw_timer humidicon_timer;       // Starts a HumidIcon measurement every second
+sw_timer humidicon_read_timer;  // Fetches the reading once it is ready
+sw_timer stack_timer;           // Checks the stack headroom every second
+sw_timer trend_timer;           // Adds a sample to the trend pages
+
+// The next HumidIcon reading is added to the trend history
+unsigned char trend_due;
+
+// Handlers for the events posted by the interrupts, indexed by event type
+void refresh_idle_dsp(unsigned char arg);
+void alarm_fired(unsigned char arg);
+
+const event_fn_ptr __flash event_handlers[EV_COUNT] = {
+  process_keys,         // EV_KEY
+  refresh_idle_dsp,     // EV_TICK
+  alarm_fired           // EV_ALARM
+};
+
+// Analog inputs scanned by the ADC, in ADC_SLOT_xxx order
+const unsigned char scan_channels[ADC_MAX_SLOTS] = {
+  ADC_CH_CO2, ADC_CH_LIGHT, ADC_CH_SOIL, ADC_CH_CO2_B
+};
+
 //******************************************************************************
 // Function : void format_display_time(unsigned char hrs, mins, secs)
-// Date and version : 3/25/18 version 1.0
+// Date and version : 10/19/26 version 1.1
 // Target MCU : ATmega128A @ 16MHz
 // Author : Augusto Celis / Michael Anderon
 //
 // DESCRIPTION
-// This method takes the unsigned chars for hours, minutes and seconds, and
-// formats them into the tens and ones places, and then prints the time on
-// a single line of the LCD. This function assumes that the ATMega has been
-// configured for LCD communication, and it prints the time on one line and
-// then inserts a new line character so that any printing that is done after
-// this function is done on the following line of the LCD.
+// This method takes the unsigned chars for hours, minutes and seconds and
+// writes the time as HH:MM:SS on the first line of the display buffer.
 //
 //******************************************************************************
 void format_display_time(unsigned char hrs, unsigned char mins, unsigned char
 secs) {
-  unsigned char dsp_hr_ten, dsp_hr_one, dsp_min_ten, dsp_min_one, dsp_sec_ten, 
-  dsp_sec_one;
-  
-  dsp_hr_ten = hrs / 10;
-  dsp_hr_one = hrs % 10;
-  dsp_min_ten = mins / 10;
-  dsp_min_one = mins % 10;
-  dsp_sec_ten = secs / 10;
-  dsp_sec_one = secs % 10;
+  char *p = lcd_put_P(lcd_at(0, 0), str_time);
   
-  //Display the time, temperature, and humidity on the lcd
-  printf("Time: %d%d:%d%d:%d%d\n", dsp_hr_ten, dsp_hr_one, dsp_min_ten, 
-         dsp_min_one, dsp_sec_ten, dsp_sec_one);
+  p = lcd_put_2d(p, hrs);
+  *p++ = ':';
+  p = lcd_put_2d(p, mins);
+  *p++ = ':';
+  lcd_put_2d(p, secs);
 }
 
+//******************************************************************************
+// Function : void put_hh_mm(unsigned char row, unsigned char hr_tens,
+//                           unsigned char hr_ones, unsigned char min_tens,
+//                           unsigned char min_ones)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Writes a time entered on the keypad, kept as one digit per place, as HH:MM
+// at the start of a line of the display buffer.
+//
+//******************************************************************************
+void put_hh_mm(unsigned char row, unsigned char hr_tens, unsigned char hr_ones,
+               unsigned char min_tens, unsigned char min_ones){
+  char *p = lcd_at(row, 0);
+  
+  *p++ = '0' + hr_tens;
+  *p++ = '0' + hr_ones;
+  *p++ = ':';
+  *p++ = '0' + min_tens;
+  *p++ = '0' + min_ones;
+}
 
 //******************************************************************************
 // Function : void dsp_time_temp_rh()
-// Date and version : 3/25/18 version 1.0
+// Date and version : 10/19/26 version 1.1
 // Target MCU : ATmega128A @ 16MHz
 // Author : Augusto Celis / Michael Anderon
 //
 // DESCRIPTION
 // This will use methods from humidicon.c, lcd_dog_iar_driver.c, lcd_ext.c,
 // lcd.h, and humidicon.h to display the time, temperature, and humidity on 
-// the LCD screen. 
+// the LCD screen. The time has already been read by dsp_idle_page.
 //
 //******************************************************************************
 void dsp_time_temp_rh(){
-  //Setup the RTC to read the current time
-  SPI_rtc_ds1306_config();
-  read_time_RTC();              //read the time from our registers
-  format_time();                //format time appropriately
+  humidicon_sample sample;
   
-  //Setup the humidicon for reading the temperature and humidity
-  SPI_humidicon_config();
-  read_humidicon();
+  //Get the latest temperature and humidity reading
+  read_humidicon_sample(&sample);
   
   //Setup the lcd to display the time and temperature
   init_spi_lcd();
@@ -84,75 +192,498 @@ void dsp_time_temp_rh(){
   //Break the time values into tens/ones places
   format_display_time(hours, minutes, seconds);
   
-  printf("Temp:  %2.2f%cC\n", temperature, degree_char);
-  printf("RH:    %2.2f%%", humidity);
+  char *p = lcd_put_P(lcd_at(1, 0), str_temp);
+  p = lcd_put_centi(p, sample.temperature);
+  *p++ = degree_char;
+  *p++ = 'C';
+  
+  p = lcd_put_P(lcd_at(2, 0), str_rh);
+  p = lcd_put_centi(p, sample.humidity);
+  *p++ = '%';
   
   update_lcd_dog();             //display values correctly
 }
 
 void dsp_time_co2() {
-  //Setup the RTC to read the current time
-  SPI_rtc_ds1306_config();
-  read_time_RTC();              //read the time from our registers
-  format_time();                //format time appropriately
-  
-  ADC_single_conversion();
-  
   //Setup the lcd to display the time and temperature
   init_spi_lcd();
   clear_dsp();
   
   format_display_time(hours, minutes, seconds);
-  printf("CO2 ppm:  %d\n", adc_value);
+  char *p = lcd_put_P(lcd_at(1, 0), str_co2);
+  lcd_put_int(p, cal_convert(CAL_CO2, ADC_read(ADC_SLOT_CO2)), 0);
   
   update_lcd_dog();             //display values correctly
 }
 
+//******************************************************************************
+// Function : void dsp_trend(unsigned char source,
+//                           const char __flash *label)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Trend page of one source: the latest reading on the first line, the
+// sparkline of the history on the second and its lowest and highest reading
+// on the third. Temperature and humidity are shown in hundredths.
+//
+//******************************************************************************
+void dsp_trend(unsigned char source, const char __flash *label) {
+  int low, high;
+  char *p;
+  
+  init_spi_lcd();
+  clear_dsp();
+  
+  if(!trend_render(source, 1, &low, &high)){
+    lcd_write_at_P(0, 0, label, LCD_COLUMNS);
+    lcd_write_at_P(1, 0, str_trend_empty, LCD_COLUMNS);
+    update_lcd_dog();
+    return;
+  }
+  
+  p = lcd_put_P(lcd_at(0, 0), label);
+  if(source == TREND_CO2){
+    lcd_put_int(p, trend_latest(source), 0);
+    
+    p = lcd_at(2, 0);
+    *p++ = 'L';
+    p = lcd_put_int(p, low, 0);
+    *p++ = ' ';
+    *p++ = 'H';
+    lcd_put_int(p, high, 0);
+  } else {
+    lcd_put_centi(p, trend_latest(source));
+    
+    p = lcd_at(2, 0);
+    *p++ = 'L';
+    p = lcd_put_centi(p, low);
+    *p++ = ' ';
+    *p++ = 'H';
+    lcd_put_centi(p, high);
+  }
+  
+  update_lcd_dog();
+}
+
+void dsp_trend_temp() {
+  dsp_trend(TREND_TEMP, str_temp);
+}
+
+void dsp_trend_rh() {
+  dsp_trend(TREND_RH, str_rh);
+}
+
+void dsp_trend_co2() {
+  dsp_trend(TREND_CO2, str_co2);
+}
+
+#ifdef FSM_TRACE
+//******************************************************************************
+// Function : void dsp_fsm_trace()
+// Date and version : 10/19/26 version 1.1
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Diagnostics page showing the latest entry of the FSM trace: present state,
+// key, matched row and next state, the cycles spent in the task, and the
+// time the key was handled. Hold help to send the whole trace out of the
+// serial port.
+//
+//******************************************************************************
+void dsp_fsm_trace() {
+  fsm_trace_entry entry;
+  
+  init_spi_lcd();
+  clear_dsp();
+  
+  if(fsm_trace_get(0, &entry)){
+    char *p = lcd_at(0, 0);
+    *p++ = 'S';
+    p = lcd_put_uint(p, entry.state, 0);
+    *p++ = ' ';
+    *p++ = 'K';
+    p = lcd_put_uint(p, entry.key, 0);
+    *p++ = ' ';
+    *p++ = 'R';
+    p = lcd_put_uint(p, entry.row, 0);
+    *p++ = ' ';
+    *p++ = '>';
+    *p++ = ' ';
+    *p++ = 'S';
+    lcd_put_uint(p, entry.next_state, 0);
+    
+    p = lcd_put_P(lcd_at(1, 0), str_trace_task);
+    p = lcd_put_ulong_clip(p, entry.cycles, TRACE_CYCLE_DIGITS);
+    lcd_put_P(p, str_cycles);
+    
+    p = lcd_put_P(lcd_at(2, 0), str_trace_at);
+    p = lcd_put_ulong_clip(p, entry.time, TRACE_TIME_DIGITS);
+    lcd_put_P(p, str_ms);
+  } else {
+    lcd_write_at_P(0, 0, str_trace_empty, LCD_COLUMNS);
+  }
+  
+  update_lcd_dog();
+}
+#endif
+
+#ifdef ISR_PROFILE
+//******************************************************************************
+// Function : void dsp_isr_profile()
+// Date and version : 10/19/26 version 1.1
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Diagnostics page showing the longest run of each profiled interrupt in
+// cycles, and the worst time from the 1Hz edge of the RTC to the end of the
+// frame in microseconds.
+//
+//******************************************************************************
+void dsp_isr_profile() {
+  isr_profile int1, int2, adc, tick;
+  
+  profile_get(PROF_INT1, &int1);
+  profile_get(PROF_INT2, &int2);
+  profile_get(PROF_ADC, &adc);
+  profile_get(PROF_TIMER0, &tick);
+  
+  init_spi_lcd();
+  clear_dsp();
+  
+  char *p = lcd_at(0, 0);
+  *p++ = 'I';
+  *p++ = '1';
+  p = lcd_put_uint(p, int1.max, 5);
+  *p++ = ' ';
+  *p++ = 'I';
+  *p++ = '2';
+  lcd_put_uint(p, int2.max, 5);
+  
+  p = lcd_at(1, 0);
+  *p++ = 'A';
+  *p++ = 'D';
+  p = lcd_put_uint(p, adc.max, 5);
+  *p++ = ' ';
+  *p++ = 'T';
+  *p++ = '0';
+  lcd_put_uint(p, tick.max, 5);
+  
+  p = lcd_put_P(lcd_at(2, 0), str_frame);
+  p = lcd_put_ulong_clip(p, profile_frame_max() / CYCLES_PER_US,
+                         FRAME_US_DIGITS);
+  lcd_put_P(p, str_us);
+  
+  update_lcd_dog();
+}
+#endif
+
+//******************************************************************************
+// Function : void boot_report()
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sends the time from the start of main to the first frame out of the
+// serial port.
+//
+//******************************************************************************
+void boot_report() {
+  uart_puts_P(str_boot_header);
+  uart_newline();
+  uart_put_uint(boot_frame_us / 1000);
+  uart_putc('.');
+  uart_putc('0' + (boot_frame_us / 100) % 10);
+  uart_puts_P(str_boot_ms);
+  uart_newline();
+}
+
+//******************************************************************************
+// Function : void dump_diagnostics()
+// Date and version : 10/19/26 version 1.2
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sends the boot time, the duty cycle, the SRAM budget, the FSM trace, the
+// interrupt statistics and the formatter benchmark out of the serial port,
+// whichever are built in. Runs on a long press of help.
+//
+//******************************************************************************
+void dump_diagnostics() {
+  boot_report();
+  power_report();
+  sram_report();
+#ifdef FSM_TRACE
+  fsm_trace_dump();
+#endif
+#ifdef ISR_PROFILE
+  profile_dump();
+#endif
+#ifdef FORMAT_BENCH
+  format_bench();
+#endif
+}
+
+//******************************************************************************
+// Function : void fetch_humidicon()
+// Date and version : 10/19/26 version 1.1
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Timer callback that reads the HumidIcon once its conversion is done. The
+// new reading is published for the display to pick up, and added to the
+// trend history when record_trend asked for it.
+//
+//******************************************************************************
+void fetch_humidicon(){
+  humidicon_sample sample;
+  
+  SPI_humidicon_config();
+  read_humidicon();
+  
+  if(trend_due){
+    trend_due = 0;
+    read_humidicon_sample(&sample);
+    trend_add(TREND_TEMP, sample.temperature);
+    trend_add(TREND_RH, sample.humidity);
+  }
+}
+
+//******************************************************************************
+// Function : void measure_humidicon()
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Periodic timer callback that requests a HumidIcon measurement and schedules
+// fetch_humidicon for when the conversion is done, instead of waiting for it.
+//
+//******************************************************************************
+void measure_humidicon(){
+  SPI_humidicon_config();
+  request_humidicon();
+  timer_start(&humidicon_read_timer, HUMIDICON_MEAS_MS, 0, fetch_humidicon);
+}
+
+//******************************************************************************
+// Function : void record_trend()
+// Date and version : 10/19/26 version 1.1
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Periodic timer callback that adds the latest CO2 reading to the history of
+// the trend pages. The HumidIcon is not measured unless the page on the
+// display needs it, so a measurement is started here when none is under way
+// and fetch_humidicon adds the temperature and humidity.
+//
+//******************************************************************************
+void record_trend(){
+  trend_add(TREND_CO2, cal_convert(CAL_CO2, ADC_read(ADC_SLOT_CO2)));
+  
+  trend_due = 1;
+  if(!timer_pending(&humidicon_read_timer))
+    measure_humidicon();
+}
+
+//******************************************************************************
+// Function : void dsp_idle_page()
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Draws the idle page on the display, reading the time from the RTC first if
+// the page shows it. Also the task of the FSM for going back to idle_dsp.
+// Every task that goes back to idle_dsp from another state has to call it,
+// refresh_idle_dsp only redraws a page once its refresh time is up.
+//
+//******************************************************************************
+void dsp_idle_page(){
+  const idle_page __flash *page = &idle_pages[page_index];
+  
+  if(page->sources & PAGE_SRC_RTC){
+    SPI_rtc_ds1306_config();
+    read_time_RTC();            //read the time from our registers
+    format_time();              //format time appropriately
+  }
+  
+  page->render();
+  page_age = 0;
+  page_stale = 0;
+}
+
+//******************************************************************************
+// Function : void select_page(unsigned char index)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Makes a page of idle_pages the one on the display and draws it. The
+// HumidIcon is measured every second only while the page reads it.
+//
+//******************************************************************************
+void select_page(unsigned char index){
+  page_index = index;
+  
+  if(idle_pages[index].sources & PAGE_SRC_HUMIDICON){
+    if(!timer_pending(&humidicon_timer))
+      timer_start(&humidicon_timer, 0, 1000, measure_humidicon);
+  } else {
+    timer_cancel(&humidicon_timer);
+  }
+  
+  dsp_idle_page();
+}
+
+//******************************************************************************
+// Function : void alarm_acked()
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Called by rtc_poll once the IRQF0 flag of the RTC is cleared. INT2 follows
+// the IRQ line of the RTC, so it can be turned back on now.
+//
+//******************************************************************************
+void alarm_acked(){
+  SETBIT(EIMSK, INT2);
+}
+
+//******************************************************************************
+// Function : void check_stack()
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Timer callback that checks the headroom of both stacks every second. The
+// first time one of them runs low a warning with the bytes left is shown over
+// the current screen, waiting for any other message to go first. stack_low
+// stays set, and the budget can be read out with a long press of help.
+//
+//******************************************************************************
+void check_stack(){
+  if(!stack_low && !stack_check())
+    return;
+  
+  if(overlay_showing())
+    return;
+  
+  timer_cancel(&stack_timer);
+  
+  char *p = overlay_at(1, 0);
+  for(unsigned char i = 0; i < 2 * LCD_COLUMNS; i++)
+    p[i] = ' ';
+  
+  lcd_put_P(p, str_stack_low);
+  
+  p = overlay_at(2, 0);
+  *p++ = 'C';
+  p = lcd_put_uint(p, stack_unused(STACK_CSTACK), 0);
+  *p++ = ' ';
+  *p++ = 'R';
+  p = lcd_put_uint(p, stack_unused(STACK_RSTACK), 0);
+  lcd_put_P(p, str_bytes);
+  
+  overlay_show(OVERLAY_ROWS, MESSAGE_MS);
+}
+
+//******************************************************************************
+// Function : void alarm_fired(unsigned char arg)
+// Date and version : 10/19/26 version 1.1
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Handler for EV_ALARM. The beeps were already started by ISR_INT2, this
+// queues the write that clears the IRQF0 flag of the RTC. rtc_poll sends it
+// once the SPI is free and alarm_acked turns INT2 back on.
+//
+//******************************************************************************
+void alarm_fired(unsigned char arg){
+  
+  //Clear out the IRQF0 status flag
+  if(!rtc_queue_write(STAT_REG_WT, 0x00, alarm_acked)){
+    //Queue full, clear it here
+    SPI_rtc_ds1306_config();
+    write_RTC(STAT_REG_WT, 0x00);
+    alarm_acked();
+  }
+}
+
+//******************************************************************************
+// Function : void refresh_idle_dsp(unsigned char arg)
+// Date and version : 10/19/26 version 1.1
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Handler for EV_TICK. Because idle_dsp is our initial state, we will start
+// off diaplying the time and temperature. Many of our states return to this
+// idle_dsp state as well so this will help to show the idle_dsp value. The
+// page is drawn again once its refresh time has gone by, or right away if
+// another screen was up. The time from the 1Hz edge to the end of the frame
+// is profiled.
+//
+//******************************************************************************
+void refresh_idle_dsp(unsigned char arg){
+  
+  if(present_state != idle_dsp){
+    page_stale = 1;
+    return;
+  }
+  
+  if(page_stale || ++page_age >= idle_pages[page_index].refresh_s){
+    dsp_idle_page();
+#ifdef ISR_PROFILE
+    profile_frame_done();
+#endif
+  }
+  
+}
+
 /*
 *Interrupt that is set off by Alarm0 from the RTC.
-*Will show a change of logic for half a second
+*Starts the beeps on Timer3 and leaves the rest to
+*alarm_fired. The IRQ line stays low until the flag is
+*cleared over SPI, so INT2 is turned off until then.
 */
 #pragma vector = INT2_vect
 __interrupt void ISR_INT2(void){
+  PROFILE_ENTER(PROF_INT2);
   
-  //Toggle a logic 1 -> logic 0
-  SETBIT(PORTA, 7);
-  __delay_cycles(16000000);
-  CLEARBIT(PORTA, 7);
-  
-  //Clear out the IRQF0 status flag
-  write_RTC(STAT_REG_WT, 0x00);
+  CLEARBIT(EIMSK, INT2);
+  alarm_pulse_start(ALARM_PATTERN, ALARM_PLAYS);
+  event_post(EV_ALARM, 0);
   
+  PROFILE_EXIT(PROF_INT2);
 }
 
 /*
 *This will be the value that is set off by the RTC
-*1Hz wave. Because idle_dsp is our initial state, we 
-*will start off diaplying the time and temperature.
-*Many of our states return to this idle_dsp state as well
-*so this will help to show the idle_dsp value
+*1Hz wave. The display is refreshed by refresh_idle_dsp.
 */
 #pragma vector = INT1_vect
 __interrupt void ISR_INT1(void){
+  PROFILE_ENTER(PROF_INT1);
   
-  if(present_state == idle_dsp){
-    if(page_index == 0)
-      dsp_time_temp_rh();
-    else if (page_index == 1)
-      dsp_time_co2();
-  }
+#ifdef ISR_PROFILE
+  profile_tick_edge();
+#endif
+  power_second();
+  event_post(EV_TICK, 0);
   
-}
-
-/*
-*Interrupt that is set off by the conversion end of 
-*the ADC itself. This will setup the value which 
-*will be updated ot the LCD screen
-*/
-#pragma vector = ADC_vect
-__interrupt void ISR_ADC(){
-  adc_value = (int)ADCH << 8;
-  adc_value |= (int)ADCL;
+  PROFILE_EXIT(PROF_INT1);
 }
 
 void main(){
@@ -167,13 +698,22 @@ void main(){
   SETBIT(PORTB, 0);     //Select for LCD (Unassert)
   
   // Configure PortC for keypad, initial configuration
-  DDRC = 0xF0;          // High nibble outputs, low nibble inputs 
-  PORTC = 0x0F;      
+  DDRC = 0x80;          // Only the first column is an output, driven low,
+  PORTC = 0x7F;         // pullups on the other columns and the rows
   
   //Configure PortD for Inerrupts
-  DDRD = 0xF8;          //INT0, INT1, INT2
+  DDRD = 0xF8;          //INT1, INT2
   PORTD = 0x05;         //Set pullup resistors on INT0 and INT2
   
+  //The LCD needs 40ms after power up before its first command. Start the
+  //cycle counter and the system tick, which also scans the keypad, first
+  //and set up everything else while that time runs out. The external
+  //interrupts stay off until the first frame is up.
+  profile_init();
+  timer_init();
+  __enable_interrupt();
+  unsigned long boot_start = cycles_now();
+  
   //Config RTC clock for interrupt
   SPI_rtc_ds1306_config();
   
@@ -187,20 +727,71 @@ void main(){
   write_RTC(HR_WT, 0x00);               //Initialize hours, minutes
   write_RTC(MIN_WT, 0x00);              //and seconds to display
   write_RTC(SEC_WT, 0X00);              //00:00:00
-
-  present_state = idle_dsp;             //Setup the intiial state of our FSM
   
-  init_lcd_dog();
+  //Start the first HumidIcon measurement, it is ready by the time the LCD is
+  SPI_humidicon_config();
+  request_humidicon();
+  unsigned long humidicon_start = cycles_now();
   
-  //Enable interrupt config
-  MCUCR = 0X30;
-  EIMSK = 0X07;
-  __enable_interrupt();
+  //Scan all analog inputs continuously, about 2 results per second each.
+  //The first conversion also warms up the ADC.
+  ADC_scan_config(scan_channels, ADC_MAX_SLOTS, ADC_RATE_9HZ);
+  
+  //The CO2 sensor picks up spikes when the chamber relays switch
+  ADC_set_median(ADC_SLOT_CO2, ADC_MEDIAN_5);
+  ADC_set_median(ADC_SLOT_CO2_B, ADC_MEDIAN_5);
   
-  __delay_cycles(20);
+  //The diagnostics can be sent out of the serial port on request
+  uart_init();
+  
+  present_state = idle_dsp;             //Setup the intiial state of our FSM
   
+  //Wait out what is left of the power up time of the LCD and set it up. It
+  //returns once the clear display command is done, so the first frame can
+  //be flushed right after, whether the HumidIcon wait below takes any time
+  //or not.
+  init_lcd_dog_after((cycles_now() - boot_start) / CYCLES_PER_US);
+  
+  //Fetch the first HumidIcon reading for the first frame
+  while(cycles_now() - humidicon_start
+        < HUMIDICON_MEAS_MS * 1000UL * CYCLES_PER_US){
+    //Conversion still running
+  }
+  fetch_humidicon();
+  
+  //Measure the humidity and temperature every second from here on, while
+  //the first page shows them
+  timer_start(&humidicon_timer, 1000, 1000, measure_humidicon);
+  timer_start(&stack_timer, 1000, 1000, check_stack);
+  timer_start(&trend_timer, 2000, TREND_PERIOD_MS, record_trend);
+  
+  //Draw the first frame now instead of waiting for the first 1Hz edge
+  select_page(page_index);
+  lcd_wait();
+  boot_frame_us = (cycles_now() - boot_start) / CYCLES_PER_US;
+  boot_report();
+  
+  //Enable interrupt config. INT1 is the 1Hz output of the RTC and has to be
+  //edge triggered now that its ISR returns right away. The keypad is scanned
+  //from the system tick, so INT0 is not used. The sleep mode bits of MCUCR
+  //are set by power_sleep.
+  EICRA = (1 << ISC11) | (0 << ISC10);
+  EIMSK = 0X06;
+  
+  //Run the timers that are due, the handler of the next event and the RTC
+  //writes waiting for the SPI, forever. Every handler runs to completion, so
+  //the interrupts only have to post. Once there is nothing left to do the
+  //CPU sleeps until the next interrupt. RTC writes held back by an LCD flush
+  //are sent after the interrupt that ends the flush wakes it.
   while(1){
+    timer_poll();
+    event_dispatch();
+    rtc_poll();
     
+    __disable_interrupt();
+    if(!event_waiting() && !timer_due())
+      power_sleep();
+    __enable_interrupt();
   }
 }
 
@@ -222,10 +813,8 @@ void dsp_options_screen(){
   init_spi_lcd();
   clear_dsp();
   
-  __delay_cycles(1000);
-  
-  printf("1:Set time/alarm");
-  printf("2:Toggle alarm");
+  lcd_write_at_P(0, 0, str_options_1, LCD_COLUMNS);
+  lcd_write_at_P(1, 0, str_options_2, LCD_COLUMNS);
   
   update_lcd_dog();          
   
@@ -246,11 +835,15 @@ void dsp_instr_screen(){
   init_spi_lcd();
   clear_dsp();
   
-    __delay_cycles(1000);
-
-  printf("2nd%c1: Set time\n", ARROW);
-  printf("       or Alarm\n");
-  printf("2nd%c2: Alarm Y/N", ARROW);
+  char *p = lcd_put_P(lcd_at(0, 0), str_2nd);
+  *p++ = ARROW;
+  lcd_put_P(p, str_instr_1);
+  
+  lcd_write_at_P(1, 0, str_instr_2, LCD_COLUMNS);
+  
+  p = lcd_put_P(lcd_at(2, 0), str_2nd);
+  *p++ = ARROW;
+  lcd_put_P(p, str_instr_3);
   
   update_lcd_dog();
 }
@@ -267,6 +860,7 @@ void dsp_instr_screen(){
 //
 //******************************************************************************
 void toggle_alarm_enable(){
+  SPI_rtc_ds1306_config();
   unsigned char control_reg = read_RTC(CONT_REG_RD);
   control_reg ^= 0x01;
   write_RTC(CONT_REG_WT, control_reg);
@@ -277,9 +871,9 @@ void toggle_alarm_enable(){
   clear_dsp();
   
   if((control_reg & 0x01) == 0x01) {
-    printf("Alarm is On\n");
+    lcd_write_at_P(0, 0, str_alarm_on, LCD_COLUMNS);
   } else {
-    printf("Alarm is Off\n");
+    lcd_write_at_P(0, 0, str_alarm_off, LCD_COLUMNS);
   }
   
   unsigned char temp_read_hr = read_RTC(HR_ALM_RD);
@@ -299,8 +893,13 @@ void toggle_alarm_enable(){
   tens *= 10;
   temp_read_hr = (tens + ones);
   
-  printf("ALM: %d:%d:00\n", temp_read_hr, temp_read_min);
-  printf("Press any key");
+  char *p = lcd_put_P(lcd_at(1, 0), str_alarm);
+  p = lcd_put_2d(p, temp_read_hr);
+  *p++ = ':';
+  p = lcd_put_2d(p, temp_read_min);
+  lcd_put_P(p, str_zero_seconds);
+  
+  lcd_write_at_P(2, 0, str_press_any_key, LCD_COLUMNS);
   
   update_lcd_dog();
 }
@@ -330,14 +929,10 @@ void dsp_enter_time(){
   time_min_ones=0;
   time_index = 0;
   
-    __delay_cycles(2000);
-
-  printf("Enter Time/Alarm");
-  printf("Enter to end\n");
-  printf("00:00");
+  lcd_write_at_P(0, 0, str_enter_time, LCD_COLUMNS);
+  lcd_write_at_P(1, 0, str_enter_to_end, LCD_COLUMNS);
+  put_hh_mm(2, 0, 0, 0, 0);
   
-    __delay_cycles(1000);
-
   update_lcd_dog();
   
 }
@@ -407,9 +1002,7 @@ void dsp_set_time() {
     //Should not happen
   }
   
-  printf("\r");
-  printf("%d%d:%d%d", time_hr_tens, time_hr_ones, time_min_tens, 
-         time_min_ones);
+  put_hh_mm(2, time_hr_tens, time_hr_ones, time_min_tens, time_min_ones);
   
   init_spi_lcd();
   update_lcd_dog();
@@ -434,23 +1027,24 @@ void dsp_time_alarm_choice(){
   clear_dsp();
   
   minutes_ones = keyConversion;
-  printf("Time entered:\n");
-  printf("%d%d:%d%d\n", time_hr_tens, time_hr_ones, time_min_tens, time_min_ones);
-  printf("Time(1) Alarm(2)");
+  lcd_write_at_P(0, 0, str_time_entered, LCD_COLUMNS);
+  put_hh_mm(1, time_hr_tens, time_hr_ones, time_min_tens, time_min_ones);
+  lcd_write_at_P(2, 0, str_time_or_alarm, LCD_COLUMNS);
   
   update_lcd_dog();  
 }
 
 //******************************************************************************
 // Function : void set_system_time()
-// Date and version : 3/25/18 version 1.0
+// Date and version : 10/19/26 version 1.1
 // Target MCU : ATmega128A @ 16MHz
 // Author : Augusto Celis / Michael Anderon
 //
 // DESCRIPTION
 // This will use methods from DS1306_RTC_drivers.c and DS1306_RTC.h to set up 
 // the time of the RTC. This will load in the values of hour and minutes as 
-// the time that the user has inputted.
+// the time that the user has inputted. The idle page is drawn over the time
+// entry screen with the new time.
 //
 //******************************************************************************
 void set_system_time(){
@@ -461,18 +1055,21 @@ void set_system_time(){
   write_RTC(HR_WT, temp_hr);
   write_RTC(MIN_WT, temp_mins);
   write_RTC(SEC_WT, 0x00);
+  
+  dsp_idle_page();
 }
 
 //******************************************************************************
 // Function : void set_system_alarm()
-// Date and version : 3/25/18 version 1.0
+// Date and version : 10/19/26 version 1.1
 // Target MCU : ATmega128A @ 16MHz
 // Author : Augusto Celis / Michael Anderon
 //
 // DESCRIPTION
 // This will use methods from DS1306_RTC_drivers.c and DS1306_RTC.h to set up 
 // the Alarm0 of the RTC. This will load in the values of hour and minutes as 
-// the time that the user has inputted.
+// the time that the user has inputted. The idle page is drawn over the time
+// entry screen.
 //
 //******************************************************************************
 void set_system_alarm(){
@@ -483,152 +1080,108 @@ void set_system_alarm(){
   write_RTC(HR_ALM_WT, temp_hr);
   write_RTC(MIN_ALM_WT, temp_mins);
   write_RTC(SEC_ALM_WT, 0x00);
-
+  
+  dsp_idle_page();
 }
 
 //******************************************************************************
-// Function : void scroll_dsp_down()
-// Date and version : 3/25/18 version 1.0
+// Function : void scroll_dsp_up()
+// Date and version : 10/19/26 version 1.1
 // Target MCU : ATmega128A @ 16MHz
 // Author : Augusto Celis / Michael Anderon
 //
 // DESCRIPTION
-// This method simply modifies the global variable page_index to make the dsp
-// show a page lower than the current page. This method implements the checks
-// to ensure that pages loop around when the page limit is reached. The page
-// limit is stored in a declared value PAGE_COUNT
+// This method moves to the next page of idle_pages and draws it. This method
+// implements the checks to ensure that pages loop around when the page limit
+// is reached. The page limit is stored in a declared value PAGE_COUNT
 //
 //******************************************************************************
 void scroll_dsp_up() {
   //If the page_index is less than the last page
   if(page_index < PAGE_COUNT-1)
-    //increment the page index to move to the next page
-    page_index++;
+    //move to the next page
+    select_page(page_index + 1);
   //if the page index is on the last page
-  else if(page_index == PAGE_COUNT-1)
+  else
     //roll over to display the first page
-    page_index = 0;
+    select_page(0);
 }
 
 //******************************************************************************
-// Function : void set_system_alarm()
-// Date and version : 3/25/18 version 1.0
+// Function : void scroll_dsp_down()
+// Date and version : 10/19/26 version 1.1
 // Target MCU : ATmega128A @ 16MHz
 // Author : Augusto Celis / Michael Anderon
 //
 // DESCRIPTION
-// This will use methods from DS1306_RTC_drivers.c and DS1306_RTC.h to set up 
-// the Alarm0 of the RTC. This will load in the values of hour and minutes as 
-// the time that the user has inputted.
+// This method moves to the previous page of idle_pages and draws it, rolling
+// over to the last page from the first one.
 //
 //******************************************************************************
 void scroll_dsp_down() {
   //If the page index is higher than 0
   if(page_index > 0) {
     //scroll down a page
-    page_index--;
+    select_page(page_index - 1);
   }
-  //If the page index is currently the last page
-  else if(page_index == 0) {
+  //If the page index is currently the first page
+  else {
     //Roll over and go to the last page to display
-    page_index = PAGE_COUNT - 1;
+    select_page(PAGE_COUNT - 1);
   }
 }
 
 //******************************************************************************
 // Function : void invalid_key()
-// Date and version : 3/25/18 version 1.0
+// Date and version : 10/19/26 version 1.3
 // Target MCU : ATmega128A @ 16MHz
 // Author : Augusto Celis / Michael Anderon
 //
 // DESCRIPTION
-// This will use methods from lcd_dog_iar_driver.c, lcd_ext.c, and lcd.h to show
-// up when the user presses an invalid key at various points through the program.
-// It will simply show an invalid key value and go back to the beggining screen
-// showing the time, tempertaure, and humidity of the system.
+// This will use methods from overlay.c to show up when the user presses an
+// invalid key at various points through the program. It shows an invalid key
+// message over the screen for MESSAGE_MS while the fsm goes back to the
+// idle page, which is drawn under the message when the key came from another
+// screen.
 //
 //******************************************************************************
 void invalid_key(){
-  init_spi_lcd();
-  clear_dsp();
-  
-    __delay_cycles(2000);
-
-  printf("Invalid key!");
-  update_lcd_dog();
-  
-  __delay_cycles(32000000);
+  if(present_state != idle_dsp)
+    dsp_idle_page();
   
-  dsp_time_temp_rh();
+  overlay_message(str_invalid_key, 0, MESSAGE_MS);
 }
 
 //******************************************************************************
 // Function : void invalid_time_entry()
-// Date and version : 3/25/18 version 1.0
+// Date and version : 10/19/26 version 1.2
 // Target MCU : ATmega128A @ 16MHz
 // Author : Augusto Celis / Michael Anderon
 //
 // DESCRIPTION
-// This will use methods from lcd_dog_iar_driver.c, lcd_ext.c, and lcd.h to show
-// up when the user presses an invalid key at moments when the user is setting 
-// up the time of the clock. This will display an error message to the user and 
-// then go back to specific screens based on the present state of the fsm.
+// This will use methods from overlay.c to show up when the user presses an
+// invalid key at moments when the user is setting up the time of the clock.
+// The error message covers the time entry screen for MESSAGE_MS, then the
+// screen with the digits entered so far comes back.
 //
 //******************************************************************************
 void invalid_time_entry(){
-  init_spi_lcd();
-  clear_dsp();
-   __delay_cycles(2000);
-
-  printf("Invalid time\n");
-  printf("entry");
-  update_lcd_dog();
-  
-  __delay_cycles(32000000);
-  
-  clear_dsp();
-  
-  __delay_cycles(100);
-  
-  printf("Enter Time/Alarm");
-  printf("Enter to end\n");
-  printf("%d%d:%d%d", time_hr_tens, time_hr_ones, time_min_tens, time_min_ones);
-  
-  update_lcd_dog();
-  
+  overlay_message(str_invalid_time, str_entry, MESSAGE_MS);
 }
 
 //******************************************************************************
-// Function : void time_alarm_choice()
-// Date and version : 3/25/18 version 1.0
+// Function : void invalid_time_alarm_choice()
+// Date and version : 10/19/26 version 1.2
 // Target MCU : ATmega128A @ 16MHz
 // Author : Augusto Celis / Michael Anderon
 //
 // DESCRIPTION
-// This will use methods from lcd_dog_iar_driver.c, lcd_ext.c, and lcd.h to show
-// up when the user presses an invalid key when choosing between setting the 
-// entered time to the alarm or time registers of the RTC. It will display an 
-// error message for 2 seconds. After the error message, it will show the 
-// user the time they entered and their options.
+// This will use methods from overlay.c to show up when the user presses an
+// invalid key when choosing between setting the entered time to the alarm or
+// time registers of the RTC. The error message covers the screen for
+// MESSAGE_MS, then the time they entered and their options come back.
 //
 //******************************************************************************
 void invalid_time_alarm_choice(){
-  init_spi_lcd();
-  clear_dsp();
-  
-    __delay_cycles(2000);
-
-  printf("Invalid entry");
-  update_lcd_dog();
-  
-  __delay_cycles(32000000);
-  
-  clear_dsp();
-  
-  printf("Time entered:\n");
-  printf("%d%d:%d%d", hours_tens, hours_ones, minutes_tens, minutes_ones);
-  printf("Time(1) Alarm(2)");
-  
-  update_lcd_dog();
+  overlay_message(str_invalid_entry, 0, MESSAGE_MS);
 }
-
@@ -21,20 +21,30 @@
 //
 //**************************************************************************
 
-//This will be the humidity and temperature extern values for 
-//the driver and the main
-extern float humidity;
-extern float temperature;
+//One reading of the humidity and temperature, in units of 0.01 %RH and 0.01
+//degrees C. Both fields always come from the same measurement.
+typedef struct{
+  int humidity;
+  int temperature;
+} humidicon_sample;
+
+//Time from a measurement request until the reading is ready, in ms
+#define HUMIDICON_MEAS_MS 37
 
 //This will help to get external functions from out humidicon drivers
 extern void SPI_humidicon_config();
+extern void request_humidicon();
 extern void read_humidicon();
+extern void read_humidicon_sample(humidicon_sample *sample);
 
 //These are methods from the main used to compute the actual temperature
 //and humidity of the system
-extern float compute_scaled_rh(unsigned int rh);
-extern float compute_scaled_temp(unsigned int temp);
+extern int compute_scaled_rh(unsigned int rh);
+extern int compute_scaled_temp(unsigned int temp);
 extern void meas_display_rh_temp();
 
 //The hex value for the degree character to display on our LCD screen
-extern char degree_char;      
+extern char degree_char;
+
+//Static SRAM of the HumidIcon module, for the SRAM budget
+extern const unsigned int __flash humidicon_sram_bytes;      
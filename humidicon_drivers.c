@@ -2,6 +2,9 @@
 #include <intrinsics.h>
 #include <avr_macros.h>
 #include "humidicon.h"
+#include "lcd.h"
+#include "calibration.h"
+#include "seqlock.h"
 
 #define HUMIDICON_SELECT 0
 #define SS_BAR 0
@@ -16,11 +19,19 @@ unsigned int humidicon_byte4;
 unsigned int humidity_raw;
 unsigned int temperature_raw;
 
-float humidity;
-float temperature;
+//The latest scaled reading, published through a sequence lock so that
+//readers never see the humidity of one measurement with the temperature of
+//another
+SEQLOCK(humidicon_sample) humidicon_latest;
  
 char degree_char = 0xDF;
 
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash humidicon_sram_bytes =
+  sizeof(humidicon_byte1) + sizeof(humidicon_byte2) + sizeof(humidicon_byte3)
+  + sizeof(humidicon_byte4) + sizeof(humidity_raw) + sizeof(temperature_raw)
+  + sizeof(humidicon_latest) + sizeof(degree_char);
+
 //******************************************************************************
 // Function : void SPI_humidicon_config (void)
 // Date and version : 3/25/18 version 1.0
@@ -34,6 +45,7 @@ char degree_char = 0xDF;
 //
 //******************************************************************************
 void SPI_humidicon_config(){
+    lcd_wait();                      //Let the LCD flush finish with the SPI
     SETBIT(PORTA, HUMIDICON_SELECT); //This will unselect the humidicon
     //This will set up the SPI for the humidicon including its frequency
     SPCR = (1 << SPE) | (1 << MSTR) | (1 << CPOL) | (1 << CPHA) | (1 << SPR1) | 
@@ -68,9 +80,28 @@ unsigned char read_humidicon_byte(){
     
 }
 
+//******************************************************************************
+// Function : void request_humidicon (void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author :     Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// This function sends a measurement request to the HumidIcon by selecting it,
+// clocking one dummy byte and deselecting it again. The sensor then needs
+// HUMIDICON_MEAS_MS before read_humidicon can fetch the new reading. The
+// HumidIcon is deselected during the conversion, so the SPI bus is free for
+// the other devices in the meantime.
+//
+//******************************************************************************
+void request_humidicon(){
+    read_humidicon_byte();              //Select and clock one dummy byte
+    SETBIT(PORTA, HUMIDICON_SELECT);    //Deselect to start the conversion
+}
+
 //******************************************************************************
 // Function : void read_humidicon (void)
-// Date and version : 3/25/18 version 1.0
+// Date and version : 10/19/26 version 1.1
 // Target MCU : ATmega128A @ 16MHz
 // Author :     Augusto Celis / Michael Anderson
 
@@ -79,81 +110,86 @@ unsigned char read_humidicon_byte(){
 // read_humidicon_byte() four times to read the temperature and humidity
 // information. Is assigns the values read to the global unsigned ints 
 // humidicon_byte1, humidion_byte2, humidion_byte3, and humidion_byte4, 
-// respectively. The function then deselects the HumidIcon.
+// respectively. The function then deselects the HumidIcon. It must be called
+// at least HUMIDICON_MEAS_MS after request_humidicon.
 //
 // The function then extracts the fourteen bits corresponding to the 
 // humidity information and stores them right justified in the global unsigned 
 // int humidity_raw. Next if extracts the fourteen bits corresponding to 
 // the temperature information and stores them in the global unsigned int
-// temperature_raw. The function then returns
+// temperature_raw. Both are scaled and published together as the latest
+// sample. The function then returns
 //
 //******************************************************************************
 void read_humidicon(){            
     
     //This will read the 4 bytes, 2 for humidity and 2 for temperature. 
     humidicon_byte1 = (int)read_humidicon_byte(); 
-    __delay_cycles(16*36650);
     humidicon_byte2 = (int)read_humidicon_byte();
     humidicon_byte3 = (int)read_humidicon_byte();
     humidicon_byte4 = (int)read_humidicon_byte();
     
+    //This will deselect the humidicon
+    SETBIT(PORTA, HUMIDICON_SELECT);
+    
     //These next 2 lines will shift over the bits appropriately, mask, 
     //and combine them into one integer value
     humidity_raw = ((humidicon_byte1 & 0x3F) << 8) | (humidicon_byte2); 
     temperature_raw = (humidicon_byte3 << 6) | (humidicon_byte4 >> 2); 
     
     //This will set the values of humidity and temperature
-    humidity = compute_scaled_rh(humidity_raw);
-    temperature = compute_scaled_temp(temperature_raw);
-    
-    //This will deselect the humidicon
-    SETBIT(PORTA, HUMIDICON_SELECT);
-   
+    humidicon_sample sample;
+    sample.humidity = compute_scaled_rh(humidity_raw);
+    sample.temperature = compute_scaled_temp(temperature_raw);
+    SEQ_WRITE(humidicon_latest, sample);
 }
 
 //******************************************************************************
-// Function : unsigned int compute_scaled_rh(unsigned int rh)
-// Date and version : 3/25/18 version 1.0
+// Function : void read_humidicon_sample(humidicon_sample *sample)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Copies the latest humidity and temperature published by read_humidicon into
+// sample. Interrupts stay enabled, the copy is only repeated if a new reading
+// was published while it was being made.
+//
+//******************************************************************************
+void read_humidicon_sample(humidicon_sample *sample){
+  SEQ_READ(humidicon_latest, *sample);
+}
+
+//******************************************************************************
+// Function : int compute_scaled_rh(unsigned int rh)
+// Date and version : 10/19/26 version 1.1
 // Target MCU : ATmega128A @ 16MHz
 // Author : Augusto Celis / Michael Anderson
 //
 // DESCRIPTION
 // Computess scaled relative humidity in units of 0.01% RH from the raw 14-bit
-// realtive humidity value from the Humidicon.
+// realtive humidity value from the Humidicon. The conversion goes through the
+// RH calibration table in calibration.c, so it is done in fixed point.
 //
 //******************************************************************************
-float compute_scaled_rh(unsigned int rh){
-  unsigned int denominator = 16382;     //2 ^ 14 - 2
-  float change;
-  float result;
-  
-  change = ((float) rh) * 100;
-  result = ((float) change) / denominator;
-  
-  //(Humidity Output / denominator) * 100%
-  return result;
+int compute_scaled_rh(unsigned int rh){
+  //(Humidity Output / denominator) * 100%, plus any unit correction
+  return cal_convert(CAL_RH, rh);
 }
 
 //******************************************************************************
-// Function : unsigned int compute_scaled_temp(unsigned int temp)
-// Date and version : 3/25/18 version 1.0
+// Function : int compute_scaled_temp(unsigned int temp)
+// Date and version : 10/19/26 version 1.1
 // Target MCU : ATmega128A @ 16MHz
-// Author : Augusto Celis / Michael Anderon
+// Author : Augusto Celis / Michael Anderson
 //
 // DESCRIPTION
 // Computess scaled temperature in units of 0.01 degrees C from the raw 14-bit
-// temperature value from the Humidicon
+// temperature value from the Humidicon. The conversion goes through the
+// temperature calibration table in calibration.c, so it is done in fixed point.
 //
 //******************************************************************************
-float compute_scaled_temp(unsigned int temp){
-  unsigned int denominator = 16382;     //2 ^ 14 - 2
-  float change;
-  float result;
-  
-  change = ((float) temp) * 165;
-  change /= ((float) denominator);
-  result = ((float) change) - 40;
-    
-  //(Temperature Output / denominator) * 165 - 40
-  return result;
+int compute_scaled_temp(unsigned int temp){
+  //(Temperature Output / denominator) * 165 - 40, plus any unit correction
+  return cal_convert(CAL_TEMP, temp);
 }
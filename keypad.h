@@ -20,5 +20,38 @@
 //
 //**************************************************************************
 
+//Key event types
+#define KEY_PRESS       0
+#define KEY_RELEASE     1
+#define KEY_LONG        2       //Still held KEY_LONG_MS after the press
+#define KEY_REPEAT      3       //Auto-repeat while held
+
+//Hold time for a long press, and the default auto-repeat timing, in ms
+#define KEY_LONG_MS             800
+#define KEY_REPEAT_DELAY_MS     500
+#define KEY_REPEAT_MS           150
+
+//A key event as it sits in the FIFO
+typedef struct{
+  unsigned char code;           //Keycode, row * 4 + column
+  unsigned char type;
+  unsigned int held_ms;         //Time held, for releases, long presses
+                                //and repeats
+  unsigned long time;           //sys_ticks when it happened
+} key_event;
+
 //Holds keycode
-extern char keycode;                  
+extern char keycode;
+
+//Number of key events dropped because the FIFO was full
+extern volatile unsigned char key_overflows;
+
+//Static SRAM of the keypad module, for the SRAM budget
+extern const unsigned int __flash keypad_sram_bytes;
+
+//These are the functions located in keyscan_isr.c
+extern void keypad_scan(void);
+extern unsigned char key_get(key_event *ev);
+extern void keypad_set_repeat(unsigned int mask, unsigned int delay_ms,
+                              unsigned int period_ms);
+extern void process_keys(unsigned char arg);                  
@@ -1,20 +1,34 @@
 //******************************************************************************
 //
 // File Name            : keyscan_isr.c
-// Title                : Keypad scan interrupt service routine
+// Title                : Keypad scanner
 // Date                 : 02/07/10
 // Version              : 1.0
 // Target MCU           : ATmega128 @  MHz
 // Target Hardware      ; 
 // Author               : Ken Short
 // DESCRIPTION
-// When keypad interrupt occurs, key matirx is scanned and is encoded using
-// a table lookup. The keypad is connected to PORTC. See diagram in laboratory
-// description. 
+// The key matrix is scanned from the 1 ms Timer0 tick and each key is encoded
+// using a table lookup. The keypad is connected to PORTC. See diagram in
+// laboratory description.
+//
+// One column is driven low per tick and the rows are read on the next tick,
+// after they have had a whole millisecond to settle, so a full scan takes
+// KEY_COLUMNS ticks and nothing ever waits. Every key has an integrator that
+// counts up on each scan that finds it down and down on each scan that finds
+// it up. A key only changes state when its integrator reaches one of the
+// ends, so a bounce has to last KEY_INTEGRATE scans to be seen, and a press
+// or release is reported 16 ms after the contacts settle.
+//
+// Presses, releases, long presses and auto-repeats are queued as key events
+// in a FIFO, with the time they happened and how long the key was held. The
+// scanner is the only producer and main() the only consumer, so typing faster
+// than the fsm runs is buffered instead of lost. The last key pressed is the
+// one that is timed for long presses and auto-repeat.
 //
 // Warnings             : none
 // Restrictions         : none
-// Algorithms           : none
+// Algorithms           : Integrating debounce
 // References           : none
 //
 // Revision History     : Initial version 
@@ -22,22 +36,73 @@
 //
 //******************************************************************************
 
-//#define debug   //this can be uncommented to remove delays for simulation
-
 #include <iom128.h>         //Atmega128 definitions
 #include <intrinsics.h>     //Intrinsic functions.
 #include <avr_macros.h>     //Useful macros.
 #include <stdio.h>
 #include "keypad.h"
+#include "timer.h"
+#include "event.h"
+#include "overlay.h"
 #include "fsm.h"
 
 char keycode;
 
+//Size of the key matrix, and the number of scans a key has to be seen down
+//or up in a row before its state changes. With a 1 ms tick every key is
+//sampled every 4 ms, so a press or release takes 16 ms to be reported.
+#define KEY_COLUMNS     4
+#define KEY_ROWS        4
+#define KEY_INTEGRATE   4
+
+//Integrator of every key, indexed by keycode, and the debounced state with
+//one bit per keycode
+unsigned char key_integrator[KEY_COLUMNS * KEY_ROWS];
+unsigned int key_down;
+
+//Column that is being driven low
+unsigned char scan_column;
+
+//Key event FIFO, must be a power of two in size. key_head is the next entry
+//to write and key_tail the next to read.
+#define KEY_FIFO_SIZE   16
+#define KEY_FIFO_MASK   (KEY_FIFO_SIZE - 1)
+
+key_event key_fifo[KEY_FIFO_SIZE];
+volatile unsigned char key_head;
+volatile unsigned char key_tail;
+volatile unsigned char key_overflows;
+
+//Low 16 bits of sys_ticks when each key was pressed
+unsigned int key_press_time[KEY_COLUMNS * KEY_ROWS];
+
+//Key being timed for long press and auto-repeat, KEY_NONE if none, the tick
+//the next repeat is due and whether the long press was reported
+#define KEY_NONE        0xFF
+unsigned char hold_code = KEY_NONE;
+unsigned int hold_next_repeat;
+unsigned char hold_long_sent;
+
+//Auto-repeat settings, written by keypad_set_repeat. Up and down repeat by
+//default, keycodes 3 and 7, so the pages can be scrolled by holding the key.
+unsigned int key_repeat_mask = (1 << 3) | (1 << 7);
+unsigned int key_repeat_delay = KEY_REPEAT_DELAY_MS;
+unsigned int key_repeat_period = KEY_REPEAT_MS;
+
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash keypad_sram_bytes =
+  sizeof(keycode) + sizeof(key_integrator) + sizeof(key_down)
+  + sizeof(scan_column) + sizeof(key_fifo) + sizeof(key_head)
+  + sizeof(key_tail) + sizeof(key_overflows) + sizeof(key_press_time)
+  + sizeof(hold_code) + sizeof(hold_next_repeat) + sizeof(hold_long_sent)
+  + sizeof(key_repeat_mask) + sizeof(key_repeat_delay)
+  + sizeof(key_repeat_period);
+
 /*
 * Port pin numbers for columns and rows of the keypad
 */
 //PORT Pin Definitions.
-#define COL1  7   //pin definitions for PortB
+#define COL1  7   //pin definitions for PortC
 #define COL2  6
 #define COL3  5
 #define COL4  4
@@ -46,81 +111,198 @@ char keycode;
 #define ROW3  1
 #define ROW4  0
 
-#define INT0  0   //pin definitions for PortD
-
-/*
-* Function declarations.
-*/
-void check_release(void);
-
 /*
 * Lookup table declaration
 */
-const char tbl[16] = {1, 2, 3, 0, 4, 5, 6, 0, 7, 8, 9, 0, 0, 0, 0, 0};
+const char __flash tbl[16] = {1, 2, 3, 0, 4, 5, 6, 0, 7, 8, 9, 0, 0, 0, 0, 0};
 
 
-const key key_sequence[] = { one, two, three, up, four, five, six, down,
+const key __flash key_sequence[] = { one, two, three, up, four, five, six, down,
 seven, eight, nine, second, clear, zero, help, enter, eol};
-/*
-* Interrupt service routine
-*/
-#pragma vector=INT0_vect          // Declare vector location.
-__interrupt void ISR_INT0(void)   // Declare interrupt function
+
+//Pin of each column and row, in keycode order
+const unsigned char __flash col_pin[KEY_COLUMNS] = {COL1, COL2, COL3, COL4};
+const unsigned char __flash row_pin[KEY_ROWS] = {ROW1, ROW2, ROW3, ROW4};
+
+//******************************************************************************
+// Function : void key_put(unsigned char code, unsigned char type,
+//                         unsigned int held_ms)
+// Date and version : 10/19/26 version 1.1
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Queues a key event. The entry is filled in before key_head moves past it.
+// If the FIFO is full the event is dropped and counted in key_overflows.
+// Only called from keypad_scan.
+//
+// EV_KEY is only posted when the FIFO was empty, process_keys drains all of
+// it, so one EV_KEY at a time is enough. Posting one per key would fill the
+// high priority ring while main() is busy and drop EV_ALARM.
+//
+//******************************************************************************
+void key_put(unsigned char code, unsigned char type, unsigned int held_ms)
 {
-  
-  //Note: TESTBIT returns 0 if bit is not set and a non-zero number otherwise.
-  
-  if(!TESTBIT(PINC,ROW1))         //Find Row of pressed key.
-    keycode = 0;
-  else if(!TESTBIT(PINC,ROW2))
-    keycode = 4;
-  else if(!TESTBIT(PINC,ROW3))
-    keycode = 8;
-  else if(!TESTBIT(PINC,ROW4))
-    keycode = 12;
-  
-  DDRC = 0x0F;                    //Reconfigure PORTC for Columns.
-  PORTC = 0xF0;
-  
-#ifndef debug
-  __delay_cycles(256);            //Let PORTC settle.
-#endif
-  
-  
-  if(!TESTBIT(PINC,COL1))         //Find Column.
-    keycode += 0;
-  else if(!TESTBIT(PINC,COL2))
-    keycode += 1;
-  else if(!TESTBIT(PINC,COL3))
-    keycode += 2;
-  else if(!TESTBIT(PINC,COL4))
-    keycode += 3;
-  
-  DDRC = 0xF0;                    //Reconfigure PORTC for Rows.
-  PORTC = 0x0F;
-  
-  check_release();                //Wait for keypad release.
- 
-  keyConversion = (tbl[keycode]);  
- 
-  key key_entered = (key_sequence[keycode]);
-  
-  fsm(present_state, key_entered);    //Go through the fsm to register the 
-  //next state and keycode
-  
+  unsigned char head = key_head;
+  unsigned char tail = key_tail;
+
+  if((unsigned char)(head - tail) == KEY_FIFO_SIZE){
+    key_overflows++;
+    return;
+  }
+
+  key_event *ev = &key_fifo[head & KEY_FIFO_MASK];
+  ev->code = code;
+  ev->type = type;
+  ev->held_ms = held_ms;
+  ev->time = sys_ticks;
+  key_head = head + 1;
+
+  if(head == tail)
+    event_post(EV_KEY, 0);
+}
+
+//******************************************************************************
+// Function : void keypad_scan(void)
+// Date and version : 10/19/26 version 1.1
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Called from the Timer0 tick interrupt every millisecond. Reads the rows of
+// the column that was driven low on the last tick and runs the integrators of
+// its keys, then drives the next column low, the only column that is an
+// output. Press and release edges are
+// queued as key events. While the last key pressed stays down it is queued
+// once more as a long press after KEY_LONG_MS, and as a repeat every
+// key_repeat_period after key_repeat_delay if it is in key_repeat_mask.
+//
+//******************************************************************************
+void keypad_scan(void)
+{
+  unsigned char rows = PINC;
+  unsigned char code = scan_column;
+  unsigned int now = (unsigned int)sys_ticks;
+
+  for(unsigned char row = 0; row < KEY_ROWS; row++, code += KEY_COLUMNS){
+    unsigned int mask = 1U << code;
+
+    if(!TESTBIT(rows, row_pin[row])){         //Key is down
+      if(key_integrator[code] < KEY_INTEGRATE)
+        key_integrator[code]++;
+      if(key_integrator[code] == KEY_INTEGRATE && !(key_down & mask)){
+        key_down |= mask;                     //Press edge
+        key_press_time[code] = now;
+        hold_code = code;
+        hold_next_repeat = now + key_repeat_delay;
+        hold_long_sent = 0;
+        key_put(code, KEY_PRESS, 0);
+      } else if(code == hold_code){           //Held, time it
+        unsigned int held = now - key_press_time[code];
+        if(!hold_long_sent && held >= KEY_LONG_MS){
+          hold_long_sent = 1;
+          key_put(code, KEY_LONG, held);
+        }
+        if((key_repeat_mask & mask) && (int)(now - hold_next_repeat) >= 0){
+          hold_next_repeat += key_repeat_period;
+          key_put(code, KEY_REPEAT, held);
+        }
+      }
+    } else {                                  //Key is up
+      if(key_integrator[code] > 0)
+        key_integrator[code]--;
+      if(key_integrator[code] == 0 && (key_down & mask)){
+        key_down &= ~mask;                    //Release edge
+        if(code == hold_code)
+          hold_code = KEY_NONE;
+        key_put(code, KEY_RELEASE, now - key_press_time[code]);
+      }
+    }
+  }
+
+  //Drive the next column low and leave the other columns as inputs pulled
+  //up, so two keys down in one row never short a high output to a low one.
+  //The port is written first, the old column is only driven high for the
+  //one cycle before it turns into an input.
+  scan_column = (scan_column + 1) & (KEY_COLUMNS - 1);
+  PORTC = 0xFF & ~(1 << col_pin[scan_column]);
+  DDRC = 1 << col_pin[scan_column];
+}
+
+//******************************************************************************
+// Function : unsigned char key_get(key_event *ev)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Takes the oldest key event out of the FIFO and copies it to ev. Returns 0
+// if the FIFO is empty.
+//
+//******************************************************************************
+unsigned char key_get(key_event *ev)
+{
+  unsigned char tail = key_tail;
+
+  if(tail == key_head)
+    return 0;
+
+  *ev = key_fifo[tail & KEY_FIFO_MASK];
+  key_tail = tail + 1;
+  return 1;
+}
+
+//******************************************************************************
+// Function : void keypad_set_repeat(unsigned int mask, unsigned int delay_ms,
+//                                   unsigned int period_ms)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sets which keys auto-repeat, one bit per keycode, how long a key has to be
+// held before it starts repeating and how often it repeats after that. The
+// settings are shared with keypad_scan, so they are written with interrupts
+// off.
+//
+//******************************************************************************
+void keypad_set_repeat(unsigned int mask, unsigned int delay_ms,
+                       unsigned int period_ms)
+{
+  __istate_t state = __get_interrupt_state();
+  __disable_interrupt();
+  key_repeat_mask = mask;
+  key_repeat_delay = delay_ms;
+  key_repeat_period = period_ms;
+  __set_interrupt_state(state);
 }
 
 /*
-*  Check keypad is released and not bouncing.
+*  Handler for EV_KEY, runs from main(). Takes every key
+*  event out of the FIFO in order. Presses and repeats
+*  are converted and run through the fsm. A long press
+*  of help sends out the diagnostics.
 */
-void check_release(void)
+void process_keys(unsigned char arg)
 {
-#ifndef debug
-  while(!TESTBIT(PIND,INT0));     //Check that keypad key is released.
+  key_event ev;
+  
+  while(key_get(&ev)){
+    if(ev.type == KEY_LONG && key_sequence[ev.code] == help)
+      dump_diagnostics();             //Hold help to send the diagnostics out
+    
+    if(ev.type != KEY_PRESS && ev.type != KEY_REPEAT)
+      continue;
+    
+    keycode = ev.code;
+  
+    keyConversion = (tbl[ev.code]);  
+ 
+    key key_entered = (key_sequence[ev.code]);
   
-  __delay_cycles(8000000);          //Delay (.05secs) / (1 / 1MHz) cycles.
+    overlay_dismiss();                //A key press takes down any message
   
-  while(!TESTBIT(PIND,INT0));     //Check that key has stopped bouncing.
-#endif
-  return;
+    fsm(present_state, key_entered);  //Go through the fsm to register the 
+    //next state and keycode
+  }
 }
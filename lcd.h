@@ -28,12 +28,28 @@
  */
 
 /**
- *  This declaration tells the compiler to look for dsp_buff_x in
- *  another module. It is used by lcd_ext.c and main.c to locate the buffers.
+ *  Size of the display. The three lines are kept one after the other in
+ *  dsp_buff, so the character at row, col is dsp_buff[row * 16 + col].
  */
-extern char dsp_buff_1[16];
-extern char dsp_buff_2[16];
-extern char dsp_buff_3[16];
+#define LCD_LINES       3
+#define LCD_COLUMNS     16
+#define LCD_CELLS       (LCD_LINES * LCD_COLUMNS)
+
+/**
+ *  This declaration tells the compiler to look for dsp_buff in
+ *  another module. It is used by lcd_ext.c and main.c to locate the buffer.
+ */
+extern char dsp_buff[LCD_CELLS];
+
+/**
+ *  A message put on top of dsp_buff, see overlay.c. update_lcd_dog sends the
+ *  lines set in lcd_overlay_rows from lcd_overlay.
+ */
+extern char lcd_overlay[LCD_CELLS];
+extern unsigned char lcd_overlay_rows;
+
+//Static SRAM of the LCD module, for the SRAM budget
+extern const unsigned int __flash lcd_sram_bytes;
 
 /**
  *  Declaratios of low level lcd functions located in lcd_dog_iar_driver.asm
@@ -42,12 +58,50 @@ extern char dsp_buff_3[16];
 __version_1 extern void init_lcd_dog(void);
 __version_1 extern void update_lcd_dog(void);
 __version_1 extern void init_spi_lcd(void);
+extern void init_lcd_dog_after(unsigned long elapsed_us);
+
+/**
+ *  The frame is sent by the SPI interrupt after update_lcd_dog returns.
+ *  Other SPI devices must call lcd_wait before they use the SPI.
+ */
+extern void lcd_wait(void);
+extern volatile unsigned char lcd_flushing;
+
+/**
+ *  Loads one of the 8 user characters, shown by character codes 0 to 7.
+ */
+extern void lcd_load_glyph(unsigned char slot, const unsigned char *rows);
 
 /**
  *  These functions are located in lcd_ext.c
  */
 extern void clear_dsp(void);
 extern int putchar(int);
+extern char *lcd_at(unsigned char row, unsigned char col);
+extern void lcd_fill(unsigned char row, unsigned char col, unsigned char len,
+                     char c);
+extern void lcd_write_at(unsigned char row, unsigned char col, const char *str,
+                         unsigned char len);
+extern void lcd_write_at_P(unsigned char row, unsigned char col,
+                           const char __flash *str, unsigned char len);
+extern void lcd_write_field(unsigned char row, unsigned char col,
+                            unsigned char width, const char *str);
+extern void lcd_write_field_P(unsigned char row, unsigned char col,
+                              unsigned char width, const char __flash *str);
+
+/**
+ *  These functions are located in lcd_format.c. They write at p and return
+ *  the position after the last character written.
+ */
+extern char *lcd_put_P(char *p, const char __flash *str);
+extern char *lcd_put_2d(char *p, unsigned char value);
+extern char *lcd_put_uint(char *p, unsigned int value, unsigned char width);
+extern char *lcd_put_int(char *p, int value, unsigned char width);
+extern char *lcd_put_ulong(char *p, unsigned long value, unsigned char width);
+extern char *lcd_put_ulong_clip(char *p, unsigned long value,
+                                unsigned char digits);
+extern char *lcd_put_centi(char *p, int value);
+extern char *lcd_put_hex(char *p, unsigned int value, unsigned char digits);
 
 
 
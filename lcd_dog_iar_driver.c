@@ -11,10 +11,60 @@
 #define RS 4
 #define BLC 5
 
-//The display buffers that we have for our LCD screen
-char dsp_buff_1[16];
-char dsp_buff_2[16];
-char dsp_buff_3[16];
+//The display buffer that we have for our LCD screen, the three lines one
+//after the other
+char dsp_buff[LCD_CELLS];
+
+//Lines of a message shown on top of the display buffer, the lines set in
+//lcd_overlay_rows are sent from here instead
+char lcd_overlay[LCD_CELLS];
+unsigned char lcd_overlay_rows;
+
+//The DDRAM of the 3 line DOG-M is linear, line 1 at 0x00, line 2 at 0x10 and
+//line 3 at 0x20, and the address moves up by one with every character, so
+//the index into dsp_buff is the DDRAM address.
+#define LCD_SET_DDRAM   0x80
+
+//The 8 user characters are in CGRAM, which is set up from instruction table
+//0. init_lcd_dog leaves table 1 selected.
+#define LCD_SET_CGRAM   0x40
+#define LCD_TABLE_0     0x38
+#define LCD_TABLE_1     0x39
+#define LCD_NO_CURSOR   0xFF
+
+//Time the LCD needs after power up before its first command
+#define LCD_POWER_UP_US 40000
+
+//The clear display command runs for about 1.08ms on the ST7036, anything sent
+//before it is done is lost
+#define LCD_CLEAR_US    2000
+
+//SPI set up for the LCD, and Timer2 set up to wait the 30us an LCD command
+//takes, 60 counts of 0.5us
+#define LCD_SPCR        ((1 << SPE) | (1 << MSTR) | (1 << CPOL) | (1 << CPHA) \
+                         | (1 << SPR1) | (1 << SPR0))
+#define LCD_CMD_WAIT    59
+
+//What the display is showing, and the DDRAM address the next character goes
+//to. The flush only sends the characters that differ from the shadow.
+char lcd_shadow[LCD_CELLS];
+unsigned char lcd_cursor;
+
+//The display buffer is the back buffer the screens render into. The frame
+//being sent is copied into lcd_front by update_lcd_dog, and the SPI and
+//Timer2 interrupts send it from there.
+char lcd_front[LCD_CELLS];
+volatile unsigned char lcd_flushing;    //A flush is using the SPI
+unsigned char lcd_restart;              //A new frame came in, start over
+unsigned char lcd_pos;                  //Next cell of lcd_front to compare
+unsigned char lcd_sent_cmd;             //The byte going out is a command
+
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash lcd_sram_bytes =
+  sizeof(dsp_buff) + sizeof(lcd_overlay) + sizeof(lcd_overlay_rows)
+  + sizeof(lcd_shadow) + sizeof(lcd_cursor) + sizeof(lcd_front)
+  + sizeof(lcd_flushing) + sizeof(lcd_restart) + sizeof(lcd_pos)
+  + sizeof(lcd_sent_cmd);
 
 void lcd_spi_transmit_CMD(char comd) {
   CLEARBIT(PORTB, RS);
@@ -31,7 +81,10 @@ void lcd_spi_transmit_CMD(char comd) {
 }
 
 __version_1 void init_spi_lcd(void) {
-  SPCR = (1 << SPE) | (1 << MSTR) | (1<<CPOL) | (1<<CPHA) | (1<<SPR1) | (1<<SPR0);
+  if(lcd_flushing)      //Already set up for the LCD by the flush
+    return;
+  
+  SPCR = LCD_SPCR;
   char kill = SPSR;
   kill = SPDR;
 }
@@ -52,10 +105,30 @@ void lcd_spi_transmit_DATA(char data) {
 }
 
 __version_1 void init_lcd_dog(void) {
+  init_lcd_dog_after(0);
+}
+
+//******************************************************************************
+// Function : void init_lcd_dog_after(unsigned long elapsed_us)
+// Date and version : 10/19/26 version 1.1
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// init_lcd_dog for a caller that has already spent elapsed_us since power up
+// on other work. Only what is left of the 40ms power up time is waited
+// before the first command, in steps of 100us. It returns once the clear
+// display command has finished, so the first frame can be flushed right away.
+//
+//******************************************************************************
+void init_lcd_dog_after(unsigned long elapsed_us) {
   //C equivalent to code in the init_spd_lcd function in asm code
   init_spi_lcd();
   
-  __delay_cycles(640000); //Delay for 40ms on a 16MHz clock
+  while(elapsed_us < LCD_POWER_UP_US) {
+    __delay_cycles(1600); //Delay for 100us on a 16MHz clock
+    elapsed_us += 100;
+  }
 
   //function set 1
   char cmd = 0x39;
@@ -84,41 +157,191 @@ __version_1 void init_lcd_dog(void) {
   cmd = 0x0C;
   lcd_spi_transmit_CMD(cmd);
 
-  //clear display
+  //clear display, and wait for it before anything else is sent
   cmd = 0x01;
   lcd_spi_transmit_CMD(cmd);
+  for(unsigned int waited = 0; waited < LCD_CLEAR_US; waited += 100)
+    __delay_cycles(1600); //Delay for 100us on a 16MHz clock
 
   //entry mode
   cmd = 0x06;
   lcd_spi_transmit_CMD(cmd);
+  
+  //The clear has finished, it left spaces everywhere and the address at the
+  //first character. The shadow can only be trusted from here on, a write
+  //lost during the clear would never be sent again.
+  for(unsigned char i = 0; i < LCD_CELLS; i++)
+    lcd_shadow[i] = ' ';
+  lcd_cursor = 0;
 }
 
-__version_1 void update_lcd_dog(void) {
-  init_spi_lcd();
-
-  int charsPerLine = 16;
+//******************************************************************************
+// Function : void lcd_flush_next(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Starts sending the next byte of the flush, called with interrupts off. Only
+// the characters of lcd_front that differ from lcd_shadow are sent. The DDRAM
+// address is set only when the next changed character is not where the
+// address already points. A single unchanged character in between is sent
+// again instead, since one data byte takes less time than an address command
+// and its 30us wait. Once nothing differs the flush lets go of the SPI.
+//
+//******************************************************************************
+void lcd_flush_next(void) {
+  if(lcd_restart) {
+    lcd_restart = 0;
+    lcd_pos = 0;
+  }
   
-  //send DDRAM address
-  char cmd = 0x80;
-  lcd_spi_transmit_CMD(cmd);
+  while(lcd_pos < LCD_CELLS && lcd_front[lcd_pos] == lcd_shadow[lcd_pos])
+    lcd_pos++;
   
-  for(int i=0; i<charsPerLine; i++) {
-    lcd_spi_transmit_DATA(dsp_buff_1[i]);
+  if(lcd_pos == LCD_CELLS) {
+    SPCR = LCD_SPCR;            //Done, turn off the SPI interrupt
+    lcd_flushing = 0;
+    return;
   }
   
-  //send DDRAM address 2
-  cmd = 0x90;
-  lcd_spi_transmit_CMD(cmd);
+  unsigned char addr = lcd_pos;
+  char byte;
   
-  for(int i=0;i<charsPerLine; i++) {
-    lcd_spi_transmit_DATA(dsp_buff_2[i]);
+  if(addr == lcd_cursor || addr == lcd_cursor + 1) {
+    if(addr != lcd_cursor) {
+      addr = lcd_cursor;        //Fill the gap
+    } else {
+      lcd_pos++;
+    }
+    byte = lcd_front[addr];
+    lcd_shadow[addr] = byte;
+    lcd_cursor = addr + 1;
+    lcd_sent_cmd = 0;
+    SETBIT(PORTB, RS);
+  } else {
+    byte = LCD_SET_DDRAM | addr;
+    lcd_cursor = addr;
+    lcd_sent_cmd = 1;
+    CLEARBIT(PORTB, RS);
   }
   
-  //send DDRAM address 3
-  cmd = 0xA0;
-  lcd_spi_transmit_CMD(cmd);
+  CLEARBIT(PORTB, SS_bar);
+  SPDR = byte;
+}
+
+//******************************************************************************
+// Function : void update_lcd_dog(void)
+// Date and version : 10/19/26 version 1.3
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Hands the display buffer to the LCD and returns right away, the frame is
+// sent by the SPI interrupt. The buffer is copied into lcd_front with
+// interrupts off, so the flush always sends a whole frame and the next one
+// can be rendered into the buffer while it goes out. If a flush is already
+// running it starts over on the new frame, which only resends what changed.
+// The lines set in lcd_overlay_rows are taken from lcd_overlay instead.
+//
+//******************************************************************************
+__version_1 void update_lcd_dog(void) {
+  __istate_t state = __get_interrupt_state();
+  __disable_interrupt();
   
-  for(int i=0; i<charsPerLine;i++) {
-    lcd_spi_transmit_DATA(dsp_buff_3[i]);
+  char *dest = lcd_front;
+  for(unsigned char line = 0; line < LCD_LINES; line++) {
+    char *src = TESTBIT(lcd_overlay_rows, line) ? lcd_overlay : dsp_buff;
+    src += line * LCD_COLUMNS;
+    for(unsigned char col = 0; col < LCD_COLUMNS; col++)
+      *dest++ = *src++;
   }
+  
+  if(lcd_flushing) {
+    lcd_restart = 1;
+  } else {
+    lcd_flushing = 1;
+    lcd_pos = 0;
+    SPCR = LCD_SPCR | (1 << SPIE);
+    char kill = SPSR;
+    kill = SPDR;
+    lcd_flush_next();
+  }
+  
+  __set_interrupt_state(state);
+}
+
+//******************************************************************************
+// Function : void lcd_load_glyph(unsigned char slot, const unsigned char *rows)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Loads user character slot (0 to 7) with 8 rows of 5 pixels, top row first
+// and the leftmost pixel in bit 4. The character is shown by putting the
+// code slot in the display buffer. Characters already on the display change
+// with it. The flush is waited for since the CGRAM is written over the SPI
+// directly, and after it the DDRAM address is set again by the next flush.
+//
+//******************************************************************************
+void lcd_load_glyph(unsigned char slot, const unsigned char *rows) {
+  lcd_wait();
+  init_spi_lcd();
+  
+  lcd_spi_transmit_CMD(LCD_TABLE_0);
+  lcd_spi_transmit_CMD(LCD_SET_CGRAM | (slot << 3));
+  for(unsigned char i = 0; i < 8; i++)
+    lcd_spi_transmit_DATA(rows[i]);
+  lcd_spi_transmit_CMD(LCD_TABLE_1);
+  
+  lcd_cursor = LCD_NO_CURSOR;
+}
+
+//******************************************************************************
+// Function : void lcd_wait(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Waits for the flush to let go of the SPI. Every other SPI user calls it
+// before setting up the SPI for its own device.
+//
+//******************************************************************************
+void lcd_wait(void) {
+  while(lcd_flushing) {
+    //Flush still running
+  }
+}
+
+/*
+*Interrupt set off when a byte of the flush is sent.
+*A command needs 30us before the next byte, which is
+*timed by Timer2, a character can be followed at once.
+*/
+#pragma vector = SPI_STC_vect
+__interrupt void ISR_SPI_STC(void) {
+  SETBIT(PORTB, SS_bar);
+  
+  if(lcd_sent_cmd) {
+    TCNT2 = 0;
+    OCR2 = LCD_CMD_WAIT;
+    TIFR = (1 << OCF2);
+    SETBIT(TIMSK, OCIE2);
+    TCCR2 = (1 << WGM21) | (1 << CS21);         //CTC, clock / 8
+  } else {
+    lcd_flush_next();
+  }
+}
+
+/*
+*Interrupt set off when the 30us after an LCD command
+*are over. Stops Timer2 and goes on with the flush.
+*/
+#pragma vector = TIMER2_COMP_vect
+__interrupt void ISR_TIMER2_COMP(void) {
+  TCCR2 = 0;
+  CLEARBIT(TIMSK, OCIE2);
+  lcd_flush_next();
 }
@@ -8,16 +8,20 @@
 // Target Hardware      ; 
 // Author               : Ken Short
 // DESCRIPTION
-// The file contains two functions that make it easier for a C
-// program to use the LCD display. The function clear_dsp() clears the display
-// buffer arrays. When followed by the function update_dsp(), the 
-// display is blanked.
+// The file contains functions that make it easier for a C program to use the
+// LCD display. The function clear_dsp() clears the display buffer. When
+// followed by the function update_dsp(), the display is blanked.
 //              
 // The function putchar() puts a single character, passed to it as an argument,
 // into the display buffer at the position corresponding to the value of
 // variable index. This putchar function replaces the standard putchar funtion,
 // so a printf statement will print to the LCD   
 //
+// The lcd_write and lcd_fill functions write straight into the display buffer
+// at a row and column without going through stdio. The offset into the
+// buffer is worked out once per call, after that every character is a store
+// and an increment.
+//
 // Warnings             : none
 // Restrictions         : none
 // Algorithms           : none
@@ -31,30 +35,24 @@
 #include "lcd.h"
 
 
-static char index;    // index into display buffer
+static unsigned char index;    // index into display buffer
 
 //******************************************************************************
 // Function             : void clear_dsp(void)
-// Date and version     : 02/07/10, version 1.0
+// Date and version     : 02/07/10, version 1.1
 // Target MCU           : ATmega128
 // Author               : Ken Short
 // DESCRIPTION
-// Clears the display buffer. Treats each 16 character array separately.
+// Clears the display buffer.
 // NOTE: update_dsp must be called after to see results
 //
-// Modified 
+// Modified 10/19/26 for the single display buffer
 //******************************************************************************
 void clear_dsp(void)
 {
-  // assuming buffers might not be contiguous
-  for(char i = 0; i < 16; i++)
-    dsp_buff_1[i] = ' ';
-  
-  for(char i = 0; i < 16; i++)
-    dsp_buff_2[i] = ' ';
-  
-  for(char i = 0; i < 16; i++)
-    dsp_buff_3[i] = ' ';  
+  char *p = dsp_buff;
+  for(unsigned char i = 0; i < LCD_CELLS; i++)
+    *p++ = ' ';
   
   index = 0;
 }
@@ -62,63 +60,215 @@ void clear_dsp(void)
 
 //******************************************************************************
 // Function             : int putchar(int c)
-// Date and version     : 02/07/10, version 1.0
+// Date and version     : 10/19/26, version 1.1
 // Target MCU           : ATmega128
 // Author               : Augusto Celis / Michael Anderson
 // DESCRIPTION
 // This function displays a single ascii chararacter on the lcd at the
-// position specified by the global variable index
+// position specified by the global variable index. '\n' moves to the start
+// of the next line, '\r' blanks the line and moves to its start, '\b' moves
+// back one character and '\f' clears the display. Writing past the end of
+// the third line wraps around to the first.
 //
 // NOTE: update_dsp must be called after to see results
 // 
-// Modified 
+// Modified 10/19/26 for the single display buffer. '\r' used to blank
+// characters 2 and 3 of the first line instead of the second and third lines.
 //******************************************************************************
-char lastchar = ' ';
 int putchar(int c) {
-  if(lastchar == '\n') {
-    if(index < 16) {
-      index = 16;
-    } else if(index < 32) {
-      index = 32;
-    } else if(index < 48) {
-      index = 0;
-    }
-  } else if (lastchar == '\r') {
-    if(index < 16) {
-      for(char i = 0; i < 16; i++)
-        dsp_buff_1[i] = ' ';
-      index = 0;
-    } else if(index < 32) {
-      for(char i = 0; i < 16; i++)
-        dsp_buff_1[2] = ' ';
-      index = 16;
-    } else if(index < 48) {
-      for(char i = 0; i < 16; i++)
-        dsp_buff_1[3] = ' ';
-      index = 32;
-    }
-  } else if(lastchar == '\b') {
-    index--;
-  } else if(lastchar == '\f') {
+  if(index >= LCD_CELLS)
+    index = 0;
+  
+  switch((char)c) {
+  case '\n':
+    index = (index & ~(LCD_COLUMNS - 1)) + LCD_COLUMNS;
+    break;
+    
+  case '\r':
+    index &= ~(LCD_COLUMNS - 1);
+    lcd_fill(0, index, LCD_COLUMNS, ' ');
+    index -= LCD_COLUMNS;
+    break;
+    
+  case '\b':
+    if(index)
+      index--;
+    break;
+    
+  case '\f':
     clear_dsp();
+    break;
+    
+  default:
+    dsp_buff[index++] = (char)c;
+    break;
   }
   
-  if((char) c == 0x0A || (char)c == '\r' || (char) c == '\b' || 
-     (char) c == '\f') {
-  } else {
-    if(index < 16) {
-      dsp_buff_1[index++] = (char) c;
-    }
-    else if (index < 32) {
-      dsp_buff_2[index++ - 16] = (char) c;
-    }
-    else if(index < 48) {
-      dsp_buff_3[index++ - 32] = (char) c;
-    }
-    else {
-      index = 0;
-      dsp_buff_1[index++] = (char) c;
-    }
-  }
-  lastchar = (char)c;
+  return c;
+}
+
+
+//******************************************************************************
+// Function             : char *lcd_at(unsigned char row, unsigned char col)
+// Date and version     : 10/19/26, version 1.0
+// Target MCU           : ATmega128
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Returns a pointer to the character at row and col of the display buffer,
+// rows and columns counted from 0. A column past the end of the line goes on
+// into the next line.
+//
+// NOTE: update_dsp must be called after to see results
+//******************************************************************************
+char *lcd_at(unsigned char row, unsigned char col) {
+  return &dsp_buff[row * LCD_COLUMNS + col];
+}
+
+
+//******************************************************************************
+// Function             : void lcd_fill(unsigned char row, unsigned char col,
+//                                      unsigned char len, char c)
+// Date and version     : 10/19/26, version 1.0
+// Target MCU           : ATmega128
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Writes len copies of c starting at row and col, stopping at the end of the
+// display buffer. putchar carries on after the last character written.
+//
+// NOTE: update_dsp must be called after to see results
+//******************************************************************************
+void lcd_fill(unsigned char row, unsigned char col, unsigned char len, char c) {
+  unsigned char pos = row * LCD_COLUMNS + col;
+  
+  if(pos >= LCD_CELLS)
+    return;
+  if(len > LCD_CELLS - pos)
+    len = LCD_CELLS - pos;
+  
+  char *p = &dsp_buff[pos];
+  index = pos + len;
+  while(len--)
+    *p++ = c;
+}
+
+
+//******************************************************************************
+// Function             : void lcd_write_at(unsigned char row, unsigned char col,
+//                                          const char *str, unsigned char len)
+// Date and version     : 10/19/26, version 1.0
+// Target MCU           : ATmega128
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Copies up to len characters of str to row and col, stopping at the end of
+// str or of the display buffer. putchar carries on after the last character
+// written.
+//
+// NOTE: update_dsp must be called after to see results
+//******************************************************************************
+void lcd_write_at(unsigned char row, unsigned char col, const char *str,
+                  unsigned char len) {
+  unsigned char pos = row * LCD_COLUMNS + col;
+  
+  if(pos >= LCD_CELLS)
+    return;
+  if(len > LCD_CELLS - pos)
+    len = LCD_CELLS - pos;
+  
+  char *p = &dsp_buff[pos];
+  while(len-- && *str)
+    *p++ = *str++;
+  index = p - dsp_buff;
+}
+
+
+//******************************************************************************
+// Function             : void lcd_write_at_P(unsigned char row,
+//                                            unsigned char col,
+//                                            const char __flash *str,
+//                                            unsigned char len)
+// Date and version     : 10/19/26, version 1.0
+// Target MCU           : ATmega128
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// lcd_write_at for a string kept in flash.
+//
+// NOTE: update_dsp must be called after to see results
+//******************************************************************************
+void lcd_write_at_P(unsigned char row, unsigned char col,
+                    const char __flash *str, unsigned char len) {
+  unsigned char pos = row * LCD_COLUMNS + col;
+  
+  if(pos >= LCD_CELLS)
+    return;
+  if(len > LCD_CELLS - pos)
+    len = LCD_CELLS - pos;
+  
+  char *p = &dsp_buff[pos];
+  while(len-- && *str)
+    *p++ = *str++;
+  index = p - dsp_buff;
+}
+
+
+//******************************************************************************
+// Function             : void lcd_write_field(unsigned char row,
+//                                             unsigned char col,
+//                                             unsigned char width,
+//                                             const char *str)
+// Date and version     : 10/19/26, version 1.0
+// Target MCU           : ATmega128
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Writes str into a field of width characters at row and col, padded with
+// spaces on the right and cut short if str is longer, so whatever the field
+// held before is always covered.
+//
+// NOTE: update_dsp must be called after to see results
+//******************************************************************************
+void lcd_write_field(unsigned char row, unsigned char col, unsigned char width,
+                     const char *str) {
+  unsigned char pos = row * LCD_COLUMNS + col;
+  
+  if(pos >= LCD_CELLS)
+    return;
+  if(width > LCD_CELLS - pos)
+    width = LCD_CELLS - pos;
+  
+  char *p = &dsp_buff[pos];
+  index = pos + width;
+  for(; width && *str; width--)
+    *p++ = *str++;
+  for(; width; width--)
+    *p++ = ' ';
+}
+
+
+//******************************************************************************
+// Function             : void lcd_write_field_P(unsigned char row,
+//                                               unsigned char col,
+//                                               unsigned char width,
+//                                               const char __flash *str)
+// Date and version     : 10/19/26, version 1.0
+// Target MCU           : ATmega128
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// lcd_write_field for a string kept in flash.
+//
+// NOTE: update_dsp must be called after to see results
+//******************************************************************************
+void lcd_write_field_P(unsigned char row, unsigned char col,
+                       unsigned char width, const char __flash *str) {
+  unsigned char pos = row * LCD_COLUMNS + col;
+  
+  if(pos >= LCD_CELLS)
+    return;
+  if(width > LCD_CELLS - pos)
+    width = LCD_CELLS - pos;
+  
+  char *p = &dsp_buff[pos];
+  index = pos + width;
+  for(; width && *str; width--)
+    *p++ = *str++;
+  for(; width; width--)
+    *p++ = ' ';
 }
\ No newline at end of file
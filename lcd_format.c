@@ -0,0 +1,273 @@
+//******************************************************************************
+//
+// File Name            : lcd_format.c
+// Title                : Number and text formatting into the display buffer
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ;
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Small formatters that write straight into the display buffer, in place of
+// printf. Each one takes a pointer into dsp_buff, usually from lcd_at, and
+// returns the pointer just past what it wrote, so a line is built by chaining
+// them:
+//
+//   char *p = lcd_at(1, 0);
+//   p = lcd_put_P(p, str_temp);
+//   p = lcd_put_centi(p, sample.temperature);
+//   *p++ = 'C';
+//
+// Decimal digits are found by subtracting powers of ten kept in flash, which
+// costs a few cycles per count instead of a division by 10 per digit, and
+// none of the functions need the printf engine or a format string.
+//
+// Warnings             : The caller keeps the field inside the display
+//                        buffer, nothing is clipped
+// Restrictions         : none
+// Algorithms           : Decimal conversion by repeated subtraction
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//******************************************************************************
+
+#include "lcd.h"
+
+//Powers of ten for the decimal conversions
+const unsigned int __flash pow10_int[] = {10000, 1000, 100, 10};
+const unsigned long __flash pow10_long[] = {
+  1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10
+};
+
+const char __flash hex_digits[] = "0123456789ABCDEF";
+
+//******************************************************************************
+// Function : char *lcd_put_P(char *p, const char __flash *str)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Copies a string from flash to p.
+//
+//******************************************************************************
+char *lcd_put_P(char *p, const char __flash *str){
+  while(*str)
+    *p++ = *str++;
+  return p;
+}
+
+//******************************************************************************
+// Function : char *lcd_put_2d(char *p, unsigned char value)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Writes a value from 0 to 99 as two digits with a leading zero, for hours,
+// minutes and seconds.
+//
+//******************************************************************************
+char *lcd_put_2d(char *p, unsigned char value){
+  char tens = '0';
+
+  while(value >= 10){
+    value -= 10;
+    tens++;
+  }
+  *p++ = tens;
+  *p++ = '0' + value;
+  return p;
+}
+
+//******************************************************************************
+// Function : char *lcd_put_digits(char *p, char *digits, unsigned char count,
+//                                 unsigned char width)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Writes count digits right aligned in a field of width characters, padded
+// with spaces on the left. A width of 0, or one too small, takes just the
+// digits.
+//
+//******************************************************************************
+char *lcd_put_digits(char *p, char *digits, unsigned char count,
+                     unsigned char width){
+  while(width > count){
+    *p++ = ' ';
+    width--;
+  }
+  while(count--)
+    *p++ = *digits++;
+  return p;
+}
+
+//******************************************************************************
+// Function : char *lcd_put_uint(char *p, unsigned int value,
+//                               unsigned char width)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Writes an unsigned value in decimal without leading zeros, right aligned
+// in a field of width characters like %5u. A width of 0 works like %u.
+//
+//******************************************************************************
+char *lcd_put_uint(char *p, unsigned int value, unsigned char width){
+  char digits[5];
+  unsigned char count = 0;
+
+  for(unsigned char i = 0; i < sizeof(pow10_int) / sizeof(pow10_int[0]); i++){
+    unsigned int pow = pow10_int[i];
+    char digit = '0';
+
+    while(value >= pow){
+      value -= pow;
+      digit++;
+    }
+    if(count || digit != '0')
+      digits[count++] = digit;
+  }
+  digits[count++] = '0' + value;
+
+  return lcd_put_digits(p, digits, count, width);
+}
+
+//******************************************************************************
+// Function : char *lcd_put_int(char *p, int value, unsigned char width)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Writes a signed value in decimal, with a '-' in front when it is negative.
+// The width counts the digits only, like lcd_put_uint.
+//
+//******************************************************************************
+char *lcd_put_int(char *p, int value, unsigned char width){
+  unsigned int magnitude = value;
+
+  if(value < 0){
+    *p++ = '-';
+    magnitude = -magnitude;
+  }
+  return lcd_put_uint(p, magnitude, width);
+}
+
+//******************************************************************************
+// Function : char *lcd_put_ulong(char *p, unsigned long value,
+//                                unsigned char width)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// lcd_put_uint for 32 bit values such as cycle counts and milliseconds.
+//
+//******************************************************************************
+char *lcd_put_ulong(char *p, unsigned long value, unsigned char width){
+  char digits[10];
+  unsigned char count = 0;
+
+  for(unsigned char i = 0; i < sizeof(pow10_long) / sizeof(pow10_long[0]);
+      i++){
+    unsigned long pow = pow10_long[i];
+    char digit = '0';
+
+    while(value >= pow){
+      value -= pow;
+      digit++;
+    }
+    if(count || digit != '0')
+      digits[count++] = digit;
+  }
+  digits[count++] = '0' + (char)value;
+
+  return lcd_put_digits(p, digits, count, width);
+}
+
+//******************************************************************************
+// Function : char *lcd_put_ulong_clip(char *p, unsigned long value,
+//                                     unsigned char digits)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// lcd_put_ulong for a field of at most digits characters, from 2 to 10. A
+// value too long for the field is written as '>' and nines, >9999 for 5
+// digits, so the line never runs past the field.
+//
+//******************************************************************************
+char *lcd_put_ulong_clip(char *p, unsigned long value, unsigned char digits){
+  if(digits < 10 && value >= pow10_long[9 - digits]){
+    *p++ = '>';
+    while(--digits)
+      *p++ = '9';
+    return p;
+  }
+  return lcd_put_ulong(p, value, 0);
+}
+
+//******************************************************************************
+// Function : char *lcd_put_centi(char *p, int value)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Writes a value held in hundredths (0.01 units) as a signed decimal with two
+// fractional digits, so the fixed-point sensor values can be shown without
+// float formatting. -1234 is written as -12.34.
+//
+//******************************************************************************
+char *lcd_put_centi(char *p, int value){
+  unsigned int magnitude = value;
+  unsigned int whole = 0;
+
+  if(value < 0){
+    *p++ = '-';
+    magnitude = -magnitude;
+  }
+
+  //Split off the whole part, in steps of 10.00 first to keep the loops short
+  while(magnitude >= 1000){
+    magnitude -= 1000;
+    whole += 10;
+  }
+  while(magnitude >= 100){
+    magnitude -= 100;
+    whole++;
+  }
+
+  p = lcd_put_uint(p, whole, 0);
+  *p++ = '.';
+  return lcd_put_2d(p, (unsigned char)magnitude);
+}
+
+//******************************************************************************
+// Function : char *lcd_put_hex(char *p, unsigned int value,
+//                              unsigned char digits)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Writes the low digits hex digits of value with leading zeros, from 1 to 4.
+//
+//******************************************************************************
+char *lcd_put_hex(char *p, unsigned int value, unsigned char digits){
+  p += digits;
+
+  char *end = p;
+  while(digits--){
+    *--p = hex_digits[value & 0x0F];
+    value >>= 4;
+  }
+  return end;
+}
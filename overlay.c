@@ -0,0 +1,139 @@
+//******************************************************************************
+//
+// File Name            : overlay.c
+// Title                : Timed overlay messages
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ;
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Shows a message on top of whatever page is in the display buffer for a set
+// time. The message is written into lcd_overlay instead of dsp_buff, and
+// update_lcd_dog takes the lines it covers from there when it builds the
+// frame. The page under it keeps being drawn, so the clock keeps running on
+// the line that is not covered. When the timer fires, or a key takes the
+// message down early, the frame is built from dsp_buff alone again and the
+// page comes back without having to be redrawn.
+//
+// Warnings             : none
+// Restrictions         : none
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include <avr_macros.h>
+#include "lcd.h"
+#include "timer.h"
+#include "overlay.h"
+
+//Takes the message down when its time is up
+sw_timer overlay_timer;
+
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash overlay_sram_bytes = sizeof(overlay_timer);
+
+//******************************************************************************
+// Function : char *overlay_at(unsigned char row, unsigned char col)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns a pointer to the character at row and col of the overlay, to write
+// a message into with the formatters of lcd_format.c before overlay_show.
+//
+//******************************************************************************
+char *overlay_at(unsigned char row, unsigned char col){
+  return &lcd_overlay[row * LCD_COLUMNS + col];
+}
+
+//******************************************************************************
+// Function : void overlay_show(unsigned char rows, unsigned int timeout_ms)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Puts the lines of the overlay set in rows (bit 0 for the first line) on
+// top of the page and sends the frame. The message is taken down after
+// timeout_ms, or stays until overlay_dismiss if timeout_ms is 0. A message
+// that is already up is replaced.
+//
+//******************************************************************************
+void overlay_show(unsigned char rows, unsigned int timeout_ms){
+  lcd_overlay_rows = rows;
+  update_lcd_dog();
+  
+  if(timeout_ms)
+    timer_start(&overlay_timer, timeout_ms, 0, overlay_dismiss);
+  else
+    timer_cancel(&overlay_timer);
+}
+
+//******************************************************************************
+// Function : void overlay_message(const char __flash *line_1,
+//                                 const char __flash *line_2,
+//                                 unsigned int timeout_ms)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Shows one or two lines of text over the lines in OVERLAY_ROWS for
+// timeout_ms. line_2 may be 0 for a message of one line.
+//
+//******************************************************************************
+void overlay_message(const char __flash *line_1, const char __flash *line_2,
+                     unsigned int timeout_ms){
+  char *p = overlay_at(1, 0);
+  
+  for(unsigned char i = 0; i < 2 * LCD_COLUMNS; i++)
+    p[i] = ' ';
+  
+  lcd_put_P(p, line_1);
+  if(line_2)
+    lcd_put_P(p + LCD_COLUMNS, line_2);
+  
+  overlay_show(OVERLAY_ROWS, timeout_ms);
+}
+
+//******************************************************************************
+// Function : void overlay_dismiss(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Takes the message down and sends the page under it again. Also the
+// callback of the overlay timer. Nothing happens if no message is up.
+//
+//******************************************************************************
+void overlay_dismiss(void){
+  if(!lcd_overlay_rows)
+    return;
+  
+  timer_cancel(&overlay_timer);
+  lcd_overlay_rows = 0;
+  update_lcd_dog();
+}
+
+//******************************************************************************
+// Function : unsigned char overlay_showing(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns 1 while a message is up.
+//
+//******************************************************************************
+unsigned char overlay_showing(void){
+  return lcd_overlay_rows != 0;
+}
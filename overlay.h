@@ -0,0 +1,37 @@
+//***************************************************************************
+//
+// File Name            : overlay.h
+// Title                : Header file for the timed overlay messages
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @  16MHz
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// This file includes all the declaration the compiler needs to 
+// reference the functions and variables written in the file overlay.c
+//
+// Warnings             : The overlay functions may only be called from main()
+//                        and from timer callbacks
+// Restrictions         : none
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version 
+// 
+//
+//**************************************************************************
+
+//Lines of the display covered by a message, the page stays on the first
+#define OVERLAY_ROWS    ((1 << 1) | (1 << 2))
+
+//Static SRAM of the overlay module, for the SRAM budget
+extern const unsigned int __flash overlay_sram_bytes;
+
+//These are the functions located in overlay.c
+extern char *overlay_at(unsigned char row, unsigned char col);
+extern void overlay_show(unsigned char rows, unsigned int timeout_ms);
+extern void overlay_message(const char __flash *line_1,
+                            const char __flash *line_2,
+                            unsigned int timeout_ms);
+extern void overlay_dismiss(void);
+extern unsigned char overlay_showing(void);
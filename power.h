@@ -0,0 +1,37 @@
+//***************************************************************************
+//
+// File Name            : power.h
+// Title                : Header file for the sleep modes and duty cycle
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @  16MHz
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// This file includes all the declaration the compiler needs to
+// reference the functions and variables written in the file power_drivers.c
+//
+// Warnings             : power_sleep must be called with interrupts off
+// Restrictions         : none
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//**************************************************************************
+
+//Sleep modes, lightest first
+#define POWER_IDLE      0       //Only the CPU stops
+#define POWER_ADC_NR    1       //ADC noise reduction, the I/O clock stops too
+#define POWER_SAVE      2       //Only the external interrupts wake the CPU
+#define POWER_MODES     3
+
+//Static SRAM of the power module, for the SRAM budget
+extern const unsigned int __flash power_sram_bytes;
+
+//These are the functions located in power_drivers.c
+extern unsigned char power_mode(void);
+extern void power_sleep(void);
+extern void power_second(void);
+extern unsigned int power_duty(void);
+extern void power_report(void);
@@ -0,0 +1,229 @@
+//******************************************************************************
+//
+// File Name            : power_drivers.c
+// Title                : Sleep modes and duty cycle
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ;
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Puts the CPU to sleep when the main loop has nothing left to do, in the
+// deepest mode the work still going on allows. The work is read from the
+// interrupt enables themselves, so a driver does not have to tell this
+// module when it starts or stops:
+//   - idle while a timer interrupt is on (the Timer0 tick, the Timer2 gap of
+//     the LCD flush, the Timer3 alarm pattern), the SPI interrupt is on or
+//     the UART is still sending, since they all need the I/O clock
+//   - ADC noise reduction when nothing else runs and the ADC is set up the
+//     way the noise canceler of the data sheet asks for: enabled in single
+//     conversion mode with its interrupt on and no conversion running. The
+//     conversion then starts once the CPU has stopped, away from the digital
+//     noise. A free running ADC, as in the scan and the capture, is left
+//     alone and the CPU sleeps in idle.
+//   - power save otherwise, the 1Hz edge and the alarm of the RTC on INT1
+//     and INT2 still wake the CPU
+//
+// The time the CPU is awake is counted with the Timer1 cycle counter, from
+// each wake up to the next sleep, and latched once a second by power_second
+// from the 1Hz interrupt. The interrupt that wakes the CPU is counted as
+// asleep, its run time is in the ISR profile.
+//
+// Warnings             : Timer1 stops in ADC noise reduction and power save,
+//                        cycles_now does not count the time asleep in them
+// Restrictions         : none
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include <avr_macros.h>
+#include "power.h"
+#include "profile.h"
+#include "uart.h"
+
+//Sleep mode bits of MCUCR
+#define POWER_SM_MASK   ((1 << SE) | (1 << SM2) | (1 << SM1) | (1 << SM0))
+
+//Work that needs the I/O clock
+#define POWER_TIMSK     ((1 << OCIE0) | (1 << OCIE2))
+#define POWER_ETIMSK    (1 << OCIE3A)
+
+//Cycles in a thousandth of a second, for the duty cycle in per mille
+#define POWER_PERMILLE  (1000UL * CYCLES_PER_US)
+
+//MCUCR sleep mode bits of each mode
+const unsigned char __flash power_sm_bits[POWER_MODES] = {
+  0,                            //POWER_IDLE
+  (1 << SM0),                   //POWER_ADC_NR
+  (1 << SM1) | (1 << SM0)       //POWER_SAVE
+};
+
+//Awake time. power_wake_at is the cycle count of the last wake up and
+//power_awake the cycles awake so far this second.
+volatile unsigned char power_asleep;
+unsigned long power_wake_at;
+unsigned long power_awake;
+unsigned long power_awake_last;         //Cycles awake in the last second
+
+//Times each mode was entered so far this second, and in the last second
+unsigned int power_sleeps[POWER_MODES];
+unsigned int power_sleeps_last[POWER_MODES];
+
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash power_sram_bytes =
+  sizeof(power_asleep) + sizeof(power_wake_at) + sizeof(power_awake)
+  + sizeof(power_awake_last) + sizeof(power_sleeps)
+  + sizeof(power_sleeps_last);
+
+//Text of the report, kept in flash
+const char __flash str_power_header[] = "# power";
+const char __flash str_awake[] = "awake ";
+const char __flash str_permille[] = " /1000";
+const char __flash str_sleep_idle[] = "idle ";
+const char __flash str_sleep_adc[] = "adc noise reduction ";
+const char __flash str_sleep_save[] = "power save ";
+
+const char __flash * const __flash str_sleep_modes[POWER_MODES] = {
+  str_sleep_idle, str_sleep_adc, str_sleep_save
+};
+
+//******************************************************************************
+// Function : unsigned char power_mode(void)
+// Date and version : 10/19/26 version 1.1
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns the deepest sleep mode the work going on allows.
+//
+//******************************************************************************
+unsigned char power_mode(void){
+  if((TIMSK & POWER_TIMSK) || (ETIMSK & POWER_ETIMSK)
+     || TESTBIT(SPCR, SPIE) || uart_busy())
+    return POWER_IDLE;
+
+  if(TESTBIT(ADCSRA, ADEN)){
+    //Free running, or a conversion already started, needs the I/O clock
+    if(TESTBIT(ADCSRA, ADFR) || TESTBIT(ADCSRA, ADSC))
+      return POWER_IDLE;
+    //Single conversion set up, the sleep starts it
+    if(TESTBIT(ADCSRA, ADIE))
+      return POWER_ADC_NR;
+  }
+
+  return POWER_SAVE;
+}
+
+//******************************************************************************
+// Function : void power_sleep(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sleeps until the next interrupt. It is called with interrupts off, after
+// the caller has checked there is nothing to do, and returns with them on.
+// The sleep instruction runs right after interrupts are turned back on, so
+// an interrupt that posts work after the check still wakes the CPU.
+//
+//******************************************************************************
+void power_sleep(void){
+  unsigned char mode = power_mode();
+
+  power_awake += cycles_now() - power_wake_at;
+  power_sleeps[mode]++;
+  power_asleep = 1;
+
+  MCUCR = (MCUCR & ~POWER_SM_MASK) | power_sm_bits[mode] | (1 << SE);
+  __enable_interrupt();
+  __sleep();
+  CLEARBIT(MCUCR, SE);
+
+  power_wake_at = cycles_now();
+  power_asleep = 0;
+}
+
+//******************************************************************************
+// Function : void power_second(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Latches the cycles the CPU was awake and the sleeps of each mode in the
+// last second and starts over. Called from the 1Hz interrupt.
+//
+//******************************************************************************
+void power_second(void){
+  if(!power_asleep){
+    unsigned long now = cycles_now();
+    power_awake += now - power_wake_at;
+    power_wake_at = now;
+  }
+
+  power_awake_last = power_awake;
+  power_awake = 0;
+
+  for(unsigned char mode = 0; mode < POWER_MODES; mode++){
+    power_sleeps_last[mode] = power_sleeps[mode];
+    power_sleeps[mode] = 0;
+  }
+}
+
+//******************************************************************************
+// Function : unsigned int power_duty(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns the part of the last second the CPU was awake, in per mille.
+//
+//******************************************************************************
+unsigned int power_duty(void){
+  __istate_t state = __get_interrupt_state();
+  __disable_interrupt();
+  unsigned long awake = power_awake_last;
+  __set_interrupt_state(state);
+
+  if(awake >= 1000 * POWER_PERMILLE)
+    return 1000;
+  return awake / POWER_PERMILLE;
+}
+
+//******************************************************************************
+// Function : void power_report(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sends the duty cycle of the last second and the number of times each
+// sleep mode was entered in it out of the serial port.
+//
+//******************************************************************************
+void power_report(void){
+  uart_puts_P(str_power_header);
+  uart_newline();
+  uart_puts_P(str_awake);
+  uart_put_uint(power_duty());
+  uart_puts_P(str_permille);
+  uart_newline();
+
+  for(unsigned char mode = 0; mode < POWER_MODES; mode++){
+    __istate_t state = __get_interrupt_state();
+    __disable_interrupt();
+    unsigned int sleeps = power_sleeps_last[mode];
+    __set_interrupt_state(state);
+
+    uart_puts_P(str_sleep_modes[mode]);
+    uart_put_uint(sleeps);
+    uart_newline();
+  }
+}
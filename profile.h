@@ -0,0 +1,82 @@
+//***************************************************************************
+//
+// File Name            : profile.h
+// Title                : Header file for the cycle counter and ISR profiler
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @  16MHz
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// This file includes all the declaration the compiler needs to 
+// reference the functions and variables written in the file profile_drivers.c
+//
+// Warnings             : none
+// Restrictions         : Timer1 is used by the cycle counter
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version 
+// 
+//
+//**************************************************************************
+
+#define ISR_PROFILE     //comment out to compile the ISR profiler out
+//#define FORMAT_BENCH  //uncomment to time printf_P against lcd_format.c,
+                        //this links printf, see format_bench.c
+
+//Timer1 counts the 16MHz clock
+#define CYCLES_PER_US   16
+
+//Interrupts that are profiled
+#define PROF_INT1       0
+#define PROF_INT2       1
+#define PROF_ADC        2
+#define PROF_TIMER0     3
+#define PROF_COUNT      4
+
+//Histogram buckets, bucket n counts runs of 2^n to 2^(n+1)-1 cycles
+#define PROF_BUCKETS    16
+
+//Run time statistics of one interrupt, in CPU cycles
+typedef struct{
+  unsigned long count;
+  unsigned long sum;
+  unsigned int min;
+  unsigned int max;
+  unsigned int hist[PROF_BUCKETS];
+} isr_profile;
+
+#ifdef ISR_PROFILE
+//Put at the very start and at the end of a profiled interrupt. The time the
+//interrupt takes to get in and out is not included.
+#define PROFILE_ENTER(id)  unsigned int prof_start = TCNT1
+#define PROFILE_EXIT(id)   profile_isr_done(id, TCNT1 - prof_start)
+
+//Put at the start of the Timer0 compare interrupt. TCNT0 has counted up
+//since the compare match reset it, which is how long the tick was held off.
+#define PROFILE_TICK_LATENCY()  { if(TCNT0 > tick_latency_max) \
+                                    tick_latency_max = TCNT0; }
+#else
+#define PROFILE_ENTER(id)
+#define PROFILE_EXIT(id)
+#define PROFILE_TICK_LATENCY()
+#endif
+
+//Worst time the tick interrupt was held off, in units of 64 cycles
+extern volatile unsigned char tick_latency_max;
+
+//Static SRAM of the profiler, for the SRAM budget
+extern const unsigned int __flash profile_sram_bytes;
+
+//These are the functions located in profile_drivers.c
+extern void profile_init(void);
+extern unsigned long cycles_now(void);
+extern void profile_isr_done(unsigned char id, unsigned int cycles);
+extern void profile_get(unsigned char id, isr_profile *copy);
+extern void profile_tick_edge(void);
+extern void profile_frame_done(void);
+extern unsigned long profile_frame_max(void);
+extern void profile_dump(void);
+#ifdef FORMAT_BENCH
+extern void format_bench(void);
+#endif
@@ -0,0 +1,279 @@
+//******************************************************************************
+//
+// File Name            : profile_drivers.c
+// Title                : Cycle counter and ISR profiler
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ; 
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Timer1 runs free from the CPU clock, so TCNT1 counts CPU cycles. The timer
+// overflow interrupt counts the upper 16 bits, which makes a 32 bit cycle
+// count that wraps every 268 s. Anything that takes less than that can be
+// timed by taking the difference of two cycles_now readings.
+//
+// The profiled interrupts read TCNT1 as they start and end and hand the
+// difference to profile_isr_done, which keeps the count, minimum, maximum and
+// sum of the run times and a histogram with a bucket per power of two. As
+// interrupts do not nest, the longest run of an interrupt is the longest any
+// other interrupt can be held off by it. The Timer0 tick also records how
+// late it started, and the time from the 1Hz edge of the RTC to the end of
+// the refresh of the display is kept as the frame latency.
+//
+// Both programs link this file, since ISR_ADC is profiled.
+//
+// Warnings             : none
+// Restrictions         : Timer1 is used by the cycle counter
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version 
+// 
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include <avr_macros.h>
+#include "profile.h"
+#include "uart.h"
+
+//Upper 16 bits of the cycle count
+volatile unsigned int cycles_high;
+
+//Statistics of the profiled interrupts, and their names for profile_dump
+isr_profile isr_profiles[PROF_COUNT];
+const char __flash name_int1[] = "INT1";
+const char __flash name_int2[] = "INT2";
+const char __flash name_adc[] = "ADC";
+const char __flash name_timer0[] = "TIMER0";
+const char __flash * const __flash profile_names[PROF_COUNT] = {
+  name_int1, name_int2, name_adc, name_timer0
+};
+
+//Text of the dump, kept in flash
+const char __flash str_profile_columns[] = "# isr count min max mean / histogram";
+const char __flash str_tick_latency[] = "tick latency ";
+const char __flash str_frame_latency[] = "frame latency ";
+
+volatile unsigned char tick_latency_max;
+
+//Cycle count at the last 1Hz edge, and the worst edge to frame time
+volatile unsigned long tick_edge;
+unsigned long frame_latency_max;
+
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash profile_sram_bytes =
+  sizeof(cycles_high) + sizeof(isr_profiles) + sizeof(tick_latency_max)
+  + sizeof(tick_edge) + sizeof(frame_latency_max);
+
+//******************************************************************************
+// Function : void profile_init(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Starts Timer1 in normal mode with no prescaler and enables its overflow
+// interrupt.
+//
+//******************************************************************************
+void profile_init(void){
+  cycles_high = 0;
+
+  for(unsigned char id = 0; id < PROF_COUNT; id++){
+    isr_profiles[id].min = 0xFFFF;
+  }
+
+  TCCR1A = 0x00;
+  TCCR1B = (0 << CS12) | (0 << CS11) | (1 << CS10);
+  TCNT1 = 0;
+  SETBIT(TIMSK, TOIE1);
+}
+
+//******************************************************************************
+// Function : unsigned long cycles_now(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns the cycle count. Both halves are read with interrupts off. If the
+// timer has overflowed but the interrupt has not run yet, the low half has
+// just wrapped and the upper half is one behind, so it is corrected here.
+//
+//******************************************************************************
+unsigned long cycles_now(void){
+  unsigned int low;
+  unsigned int high;
+
+  __istate_t state = __get_interrupt_state();
+  __disable_interrupt();
+  low = TCNT1;
+  high = cycles_high;
+  if(TESTBIT(TIFR, TOV1) && low < 0x8000)
+    high++;
+  __set_interrupt_state(state);
+
+  return ((unsigned long)high << 16) | low;
+}
+
+//******************************************************************************
+// Function : void profile_isr_done(unsigned char id, unsigned int cycles)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Adds one run of an interrupt to its statistics. Called by PROFILE_EXIT at
+// the end of the interrupt. Histogram buckets stop counting at 0xFFFF.
+//
+//******************************************************************************
+void profile_isr_done(unsigned char id, unsigned int cycles){
+  isr_profile *p = &isr_profiles[id];
+  unsigned char bucket = 0;
+
+  p->count++;
+  p->sum += cycles;
+  if(cycles < p->min)
+    p->min = cycles;
+  if(cycles > p->max)
+    p->max = cycles;
+
+  //Position of the highest bit set
+  for(unsigned int c = cycles >> 1; c; c >>= 1)
+    bucket++;
+  if(p->hist[bucket] != 0xFFFF)
+    p->hist[bucket]++;
+}
+
+//******************************************************************************
+// Function : void profile_get(unsigned char id, isr_profile *copy)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Copies the statistics of an interrupt with interrupts off, so they are all
+// from the same moment.
+//
+//******************************************************************************
+void profile_get(unsigned char id, isr_profile *copy){
+  __istate_t state = __get_interrupt_state();
+  __disable_interrupt();
+  *copy = isr_profiles[id];
+  __set_interrupt_state(state);
+}
+
+//******************************************************************************
+// Function : void profile_tick_edge(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Called by ISR_INT1 on the 1Hz edge of the RTC, notes when the frame that
+// edge starts was asked for.
+//
+//******************************************************************************
+void profile_tick_edge(void){
+  tick_edge = cycles_now();
+}
+
+//******************************************************************************
+// Function : void profile_frame_done(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Called once the display has been refreshed for a 1Hz edge, keeps the worst
+// time from the edge to here.
+//
+//******************************************************************************
+void profile_frame_done(void){
+  unsigned long now = cycles_now();
+  unsigned long edge;
+
+  __istate_t state = __get_interrupt_state();
+  __disable_interrupt();
+  edge = tick_edge;
+  __set_interrupt_state(state);
+
+  if(now - edge > frame_latency_max)
+    frame_latency_max = now - edge;
+}
+
+//******************************************************************************
+// Function : unsigned long profile_frame_max(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns the worst time from a 1Hz edge to the end of its frame, in cycles.
+//
+//******************************************************************************
+unsigned long profile_frame_max(void){
+  return frame_latency_max;
+}
+
+//******************************************************************************
+// Function : void profile_dump(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sends the statistics out of the serial port. One line per interrupt with
+// its count, minimum, maximum and mean cycles, followed by its histogram as
+// the counts of buckets 0 to 15. Then the worst tick latency and frame
+// latency, in cycles. Counts and cycles are in hex.
+//
+//******************************************************************************
+void profile_dump(void){
+  isr_profile p;
+
+  uart_puts_P(str_profile_columns);
+  uart_newline();
+
+  for(unsigned char id = 0; id < PROF_COUNT; id++){
+    profile_get(id, &p);
+
+    uart_puts_P(profile_names[id]);
+    uart_putc(' ');
+    uart_put_hex(p.count >> 16);
+    uart_put_hex(p.count);
+    uart_putc(' ');
+    uart_put_hex(p.count ? p.min : 0);
+    uart_putc(' ');
+    uart_put_hex(p.max);
+    uart_putc(' ');
+    uart_put_hex(p.count ? p.sum / p.count : 0);
+    uart_newline();
+
+    for(unsigned char bucket = 0; bucket < PROF_BUCKETS; bucket++){
+      uart_put_hex(p.hist[bucket]);
+      uart_putc(' ');
+    }
+    uart_newline();
+  }
+
+  uart_puts_P(str_tick_latency);
+  uart_put_hex(tick_latency_max * 64);
+  uart_newline();
+  uart_puts_P(str_frame_latency);
+  uart_put_hex(frame_latency_max >> 16);
+  uart_put_hex(frame_latency_max);
+  uart_newline();
+}
+
+/*
+*Interrupt set off when Timer1 wraps, every 65536
+*cycles. Counts the upper half of the cycle count.
+*/
+#pragma vector = TIMER1_OVF_vect
+__interrupt void ISR_TIMER1_OVF(void){
+  cycles_high++;
+}
@@ -0,0 +1,53 @@
+//***************************************************************************
+//
+// File Name            : seqlock.h
+// Title                : Header file for tear-free value publication
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @  16MHz
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Macros to publish a multi-byte value (an int, a struct of sensor readings)
+// from one context and read it from another without tearing and without
+// disabling interrupts. The AVR moves one byte at a time, so a reader that is
+// interrupted half way through an int can otherwise see half of an old value
+// and half of a new one.
+//
+// The value is kept twice, next to an 8 bit sequence count. The writer bumps
+// the count to odd and writes copy 0, then bumps it to even and writes
+// copy 1. A reader takes the copy the writer is not working on, selected by
+// the low bit of the count, and only reads again if the count moved while it
+// was copying. The writer never waits, and a reader that interrupts the
+// writer always finds a finished copy, so an ISR may read a value published
+// from main and the other way around.
+//
+// Warnings             : Only one writer per SEQLOCK
+// Restrictions         : none
+// Algorithms           : Sequence lock over two copies
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//**************************************************************************
+
+//Declares a published value of the given type
+#define SEQLOCK(type) struct { volatile unsigned char seq; volatile type copy[2]; }
+
+//Publishes value, called by the single writer
+#define SEQ_WRITE(lock, value) {                \
+  (lock).seq++;                                 \
+  (lock).copy[0] = (value);                     \
+  (lock).seq++;                                 \
+  (lock).copy[1] = (value);                     \
+}
+
+//Copies the latest published value into dest, retrying only when a write
+//overlapped the copy
+#define SEQ_READ(lock, dest) {                  \
+  unsigned char seq_start;                      \
+  do{                                           \
+    seq_start = (lock).seq;                     \
+    (dest) = (lock).copy[seq_start & 1];        \
+  } while(seq_start != (lock).seq);             \
+}
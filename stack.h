@@ -0,0 +1,40 @@
+//***************************************************************************
+//
+// File Name            : stack.h
+// Title                : Header file for the stack and SRAM monitor
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @  16MHz
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// This file includes all the declaration the compiler needs to 
+// reference the functions and variables written in the file stack_monitor.c
+//
+// Warnings             : none
+// Restrictions         : none
+// Algorithms           : Stack painting
+// References           : none
+//
+// Revision History     : Initial version 
+// 
+//
+//**************************************************************************
+
+//The two stacks of the IAR compiler. CSTACK holds locals and parameters,
+//RSTACK holds return addresses and is the one SP points into.
+#define STACK_CSTACK    0
+#define STACK_RSTACK    1
+
+//Fewest bytes of either stack that may stay unused before stack_check
+//raises the alarm
+#define STACK_HEADROOM_MIN 32
+
+//Set by stack_check the first time a stack runs low, stays set until reset
+extern unsigned char stack_low;
+
+//These are the functions located in stack_monitor.c
+extern unsigned int stack_size(unsigned char stack);
+extern unsigned int stack_unused(unsigned char stack);
+extern unsigned char stack_check(void);
+extern unsigned int sram_static_bytes(void);
+extern void sram_report(void);
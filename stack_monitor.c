@@ -0,0 +1,272 @@
+//******************************************************************************
+//
+// File Name            : stack_monitor.c
+// Title                : Stack high-water marks and SRAM budget
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ; 
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Before the C startup code runs, __low_level_init fills both stacks with a
+// known byte. Whatever the program later pushes overwrites it, so counting
+// how many bytes at the far end of a stack still hold the fill gives the
+// headroom that has never been used since reset, which is the high-water
+// mark of the stack. stack_check compares that with STACK_HEADROOM_MIN and
+// latches stack_low the first time either stack gets too close.
+//
+// sram_report sends the SRAM budget out of the serial port: the size and
+// high-water mark of each stack, the static SRAM of each module, which every
+// module reports in its own <module>_sram_bytes, and the total static SRAM
+// taken from the linker segments. The part of the total not reported by a
+// module is listed as other.
+//
+// Warnings             : A stack that ever held the fill byte at its far end
+//                        reads as a few bytes less used than it was
+// Restrictions         : The segment names are those of the default linker
+//                        file of the ATmega128
+// Algorithms           : Stack painting
+// References           : IAR AVR C/C++ Compiler Reference Guide,
+//                        __low_level_init and segment operators
+//
+// Revision History     : Initial version 
+// 
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include <avr_macros.h>
+#include "stack.h"
+#include "lcd.h"
+#include "DS1306_RTC.h"
+#include "humidicon.h"
+#include "ADC.h"
+#include "event.h"
+#include "keypad.h"
+#include "timer.h"
+#include "fsm.h"
+#include "profile.h"
+#include "trend.h"
+#include "overlay.h"
+#include "alarm.h"
+#include "uart.h"
+#include "power.h"
+
+#pragma segment="CSTACK"
+#pragma segment="RSTACK"
+#pragma segment="NEAR_Z"
+#pragma segment="NEAR_I"
+#pragma segment="NEAR_N"
+
+//Byte the stacks are filled with at reset
+#define STACK_PAINT     0xA5
+
+//Bytes at the top of each stack that are left alone by __low_level_init,
+//they hold its own return address and frame
+#define STACK_GUARD     16
+
+unsigned char stack_low;
+
+//Static SRAM reported by each module, for sram_report
+typedef struct{
+  const char __flash *name;
+  const unsigned int __flash *bytes;
+} sram_module;
+
+const char __flash name_lcd[] = "LCD";
+const char __flash name_rtc[] = "RTC";
+const char __flash name_humidicon[] = "HumidIcon";
+const char __flash name_adc_module[] = "ADC";
+const char __flash name_events[] = "Events";
+const char __flash name_keypad[] = "Keypad";
+const char __flash name_timers[] = "Timers";
+const char __flash name_fsm_trace[] = "FSM trace";
+const char __flash name_profiler[] = "Profiler";
+const char __flash name_trend[] = "Trend";
+const char __flash name_overlay[] = "Overlay";
+const char __flash name_alarm[] = "Alarm";
+const char __flash name_uart[] = "UART";
+const char __flash name_power[] = "Power";
+
+const sram_module __flash sram_modules[] = {
+  {name_lcd,            &lcd_sram_bytes},
+  {name_rtc,            &rtc_sram_bytes},
+  {name_humidicon,      &humidicon_sram_bytes},
+  {name_adc_module,     &adc_sram_bytes},
+  {name_events,         &event_sram_bytes},
+  {name_keypad,         &keypad_sram_bytes},
+  {name_timers,         &timer_sram_bytes},
+  {name_trend,          &trend_sram_bytes},
+  {name_overlay,        &overlay_sram_bytes},
+  {name_alarm,          &alarm_sram_bytes},
+  {name_uart,           &uart_sram_bytes},
+  {name_power,          &power_sram_bytes},
+#ifdef FSM_TRACE
+  {name_fsm_trace,      &fsm_trace_sram_bytes},
+#endif
+  {name_profiler,       &profile_sram_bytes}
+};
+
+//Text of the report, kept in flash
+const char __flash str_sram_header[] = "# sram bytes";
+const char __flash str_cstack[] = "CSTACK ";
+const char __flash str_rstack[] = "RSTACK ";
+const char __flash str_used[] = " used ";
+const char __flash str_other[] = "other ";
+const char __flash str_static[] = "static ";
+
+#define SRAM_MODULES (sizeof(sram_modules) / sizeof(sram_modules[0]))
+
+//******************************************************************************
+// Function : int __low_level_init(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Called by the startup code before the variables are set up. Paints both
+// stacks but for the STACK_GUARD bytes at their top, where this function is
+// running. Returns 1 so the startup code goes on to set up the variables.
+//
+//******************************************************************************
+int __low_level_init(void){
+  unsigned char *p;
+
+  for(p = __segment_begin("CSTACK");
+      p < (unsigned char *)__segment_end("CSTACK") - STACK_GUARD; p++)
+    *p = STACK_PAINT;
+
+  for(p = __segment_begin("RSTACK");
+      p < (unsigned char *)__segment_end("RSTACK") - STACK_GUARD; p++)
+    *p = STACK_PAINT;
+
+  return 1;
+}
+
+//******************************************************************************
+// Function : unsigned int stack_size(unsigned char stack)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns the size of STACK_CSTACK or STACK_RSTACK in bytes.
+//
+//******************************************************************************
+unsigned int stack_size(unsigned char stack){
+  if(stack == STACK_CSTACK)
+    return __segment_size("CSTACK");
+  return __segment_size("RSTACK");
+}
+
+//******************************************************************************
+// Function : unsigned int stack_unused(unsigned char stack)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns how many bytes at the far end of a stack have never been used since
+// reset. Both stacks grow down, so they are counted up from the bottom of the
+// segment until the first byte that lost its paint.
+//
+//******************************************************************************
+unsigned int stack_unused(unsigned char stack){
+  unsigned char *p;
+  unsigned char *end;
+
+  if(stack == STACK_CSTACK){
+    p = __segment_begin("CSTACK");
+    end = __segment_end("CSTACK");
+  } else {
+    p = __segment_begin("RSTACK");
+    end = __segment_end("RSTACK");
+  }
+
+  unsigned char *bottom = p;
+  while(p < end && *p == STACK_PAINT)
+    p++;
+
+  return p - bottom;
+}
+
+//******************************************************************************
+// Function : unsigned char stack_check(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns 1 and sets stack_low if either stack has less than
+// STACK_HEADROOM_MIN bytes that were never used.
+//
+//******************************************************************************
+unsigned char stack_check(void){
+  if(stack_unused(STACK_CSTACK) < STACK_HEADROOM_MIN ||
+     stack_unused(STACK_RSTACK) < STACK_HEADROOM_MIN){
+    stack_low = 1;
+    return 1;
+  }
+  return 0;
+}
+
+//******************************************************************************
+// Function : unsigned int sram_static_bytes(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns the SRAM taken by variables, zeroed, initialized and not
+// initialized ones together.
+//
+//******************************************************************************
+unsigned int sram_static_bytes(void){
+  return __segment_size("NEAR_Z") + __segment_size("NEAR_I") +
+         __segment_size("NEAR_N");
+}
+
+//******************************************************************************
+// Function : void sram_report(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sends the SRAM budget out of the serial port, one line per item with the
+// bytes in decimal. For the stacks the size is followed by the bytes used at
+// the high-water mark.
+//
+//******************************************************************************
+void sram_report(void){
+  unsigned int total = sram_static_bytes();
+  unsigned int listed = 0;
+
+  uart_puts_P(str_sram_header);
+  uart_newline();
+
+  for(unsigned char stack = STACK_CSTACK; stack <= STACK_RSTACK; stack++){
+    unsigned int size = stack_size(stack);
+    uart_puts_P(stack == STACK_CSTACK ? str_cstack : str_rstack);
+    uart_put_uint(size);
+    uart_puts_P(str_used);
+    uart_put_uint(size - stack_unused(stack));
+    uart_newline();
+  }
+
+  for(unsigned char i = 0; i < SRAM_MODULES; i++){
+    uart_puts_P(sram_modules[i].name);
+    uart_putc(' ');
+    uart_put_uint(*sram_modules[i].bytes);
+    uart_newline();
+    listed += *sram_modules[i].bytes;
+  }
+
+  uart_puts_P(str_other);
+  uart_put_uint(total - listed);
+  uart_newline();
+  uart_puts_P(str_static);
+  uart_put_uint(total);
+  uart_newline();
+}
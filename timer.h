@@ -0,0 +1,51 @@
+//***************************************************************************
+//
+// File Name            : timer.h
+// Title                : Header file for the system tick and software timers
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @  16MHz
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// This file includes all the declaration the compiler needs to
+// reference the functions and variables written in the file timer_drivers.c
+//
+// Warnings             : The timer functions may only be called from main()
+//                        and from timer callbacks
+// Restrictions         : none
+// Algorithms           : Hierarchical timer wheel
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//**************************************************************************
+
+//Pointer to a timer callback
+typedef void (*timer_fn_ptr) (void);
+
+//A software timer. The caller owns the storage, usually a global, and the
+//wheel links it into one of its slots while it is pending.
+typedef struct sw_timer{
+  struct sw_timer *next;
+  struct sw_timer **pprev;      //Link that points at this timer, 0 if idle
+  unsigned long expires;        //Tick the timer fires on
+  unsigned int period;          //Reload in ms, 0 for a one-shot timer
+  timer_fn_ptr fn;
+} sw_timer;
+
+//Milliseconds since timer_init, advanced by the Timer0 compare interrupt
+extern volatile unsigned long sys_ticks;
+
+//Static SRAM of the timer module, for the SRAM budget
+extern const unsigned int __flash timer_sram_bytes;
+
+//These are the functions located in timer_drivers.c
+extern void timer_init(void);
+extern unsigned long timer_now(void);
+extern void timer_start(sw_timer *t, unsigned int delay_ms,
+                        unsigned int period_ms, timer_fn_ptr fn);
+extern void timer_cancel(sw_timer *t);
+extern unsigned char timer_pending(sw_timer *t);
+extern void timer_poll(void);
+extern unsigned char timer_due(void);
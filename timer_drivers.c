@@ -0,0 +1,310 @@
+//******************************************************************************
+//
+// File Name            : timer_drivers.c
+// Title                : System tick and software timers
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ;
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Timer0 is set up in CTC mode to interrupt every millisecond, which advances
+// sys_ticks. Software timers are kept in a hierarchical timer wheel of three
+// levels with 16 slots each. Level 0 holds the timers due in the next 16 ms,
+// one slot per tick. Level 1 slots cover 16 ms each and level 2 slots cover
+// 256 ms each, so the wheel reaches 4 s ahead. Starting or cancelling a timer
+// links or unlinks it from a single slot, which is constant time. Every 16
+// ticks one level 1 slot is moved down into level 0, and every 256 ticks one
+// level 2 slot is moved down into level 1. Timers further out than the wheel
+// reaches are parked in its last slot and placed again when it is moved down.
+//
+// The wheel is only touched from main(). The interrupt only counts the tick,
+// and the main loop calls timer_poll to catch the wheel up and run the
+// callbacks that are due.
+//
+// Warnings             : Callbacks run from timer_poll in main() and should be
+//                        short, the timer functions must not be called from
+//                        an interrupt
+// Restrictions         : none
+// Algorithms           : Hierarchical timer wheel
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include <avr_macros.h>
+#include "timer.h"
+#include "keypad.h"
+#include "profile.h"
+
+//Size of the wheel levels, 16 slots per level
+#define WHEEL_BITS      4
+#define WHEEL_SLOTS     (1 << WHEEL_BITS)
+#define WHEEL_MASK      (WHEEL_SLOTS - 1)
+#define WHEEL_SPAN      (1L << (3 * WHEEL_BITS))
+
+//Milliseconds since timer_init
+volatile unsigned long sys_ticks;
+
+//The wheel itself, and the next tick the wheel has to process
+sw_timer *wheel_0[WHEEL_SLOTS];
+sw_timer *wheel_1[WHEEL_SLOTS];
+sw_timer *wheel_2[WHEEL_SLOTS];
+unsigned long wheel_ticks;
+
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash timer_sram_bytes =
+  sizeof(sys_ticks) + sizeof(wheel_0) + sizeof(wheel_1) + sizeof(wheel_2)
+  + sizeof(wheel_ticks);
+
+//******************************************************************************
+// Function : void timer_init(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sets up Timer0 for a 1 ms tick. The 16 MHz clock is divided by 64 and the
+// timer is cleared on a compare match with 249, which gives 1000 interrupts a
+// second.
+//
+//******************************************************************************
+void timer_init(void){
+  sys_ticks = 0;
+  wheel_ticks = 0;
+
+  TCNT0 = 0;
+  OCR0 = 249;
+  TCCR0 = (1 << WGM01) | (1 << CS02) | (0 << CS01) | (0 << CS00);
+  SETBIT(TIMSK, OCIE0);
+}
+
+//******************************************************************************
+// Function : unsigned long timer_now(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns sys_ticks. The four bytes are read with interrupts off so the tick
+// cannot change in the middle of the read.
+//
+//******************************************************************************
+unsigned long timer_now(void){
+  unsigned long now;
+
+  __istate_t state = __get_interrupt_state();
+  __disable_interrupt();
+  now = sys_ticks;
+  __set_interrupt_state(state);
+
+  return now;
+}
+
+//******************************************************************************
+// Function : void wheel_insert(sw_timer *t)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Links a timer into the slot its expiry time falls in, picking the level by
+// how far ahead of the wheel the timer expires.
+//
+//******************************************************************************
+void wheel_insert(sw_timer *t){
+  long delta = (long)(t->expires - wheel_ticks);
+  unsigned long expires = t->expires;
+  sw_timer **slot;
+
+  if(delta < 0){
+    //Already due, run it on the next tick processed. wheel_ticks is always
+    //a tick timer_poll has not taken yet, also while it runs the callbacks.
+    slot = &wheel_0[wheel_ticks & WHEEL_MASK];
+  } else if(delta < WHEEL_SLOTS){
+    slot = &wheel_0[expires & WHEEL_MASK];
+  } else if(delta < (WHEEL_SLOTS * WHEEL_SLOTS)){
+    slot = &wheel_1[(expires >> WHEEL_BITS) & WHEEL_MASK];
+  } else {
+    //Park timers beyond the reach of the wheel in its last slot
+    if(delta >= WHEEL_SPAN)
+      expires = wheel_ticks + WHEEL_SPAN - 1;
+    slot = &wheel_2[(expires >> (2 * WHEEL_BITS)) & WHEEL_MASK];
+  }
+
+  t->next = *slot;
+  if(t->next)
+    t->next->pprev = &t->next;
+  t->pprev = slot;
+  *slot = t;
+}
+
+//******************************************************************************
+// Function : void timer_start(sw_timer *t, unsigned int delay_ms,
+//                             unsigned int period_ms, timer_fn_ptr fn)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Starts a timer that calls fn after delay_ms. If period_ms is not zero the
+// timer is restarted every period_ms after that, otherwise it fires once. A
+// timer that is already pending is restarted with the new settings.
+//
+//******************************************************************************
+void timer_start(sw_timer *t, unsigned int delay_ms, unsigned int period_ms,
+                 timer_fn_ptr fn){
+  timer_cancel(t);
+
+  t->expires = timer_now() + delay_ms;
+  t->period = period_ms;
+  t->fn = fn;
+
+  wheel_insert(t);
+}
+
+//******************************************************************************
+// Function : void timer_cancel(sw_timer *t)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Stops a timer. Nothing happens if the timer is not pending.
+//
+//******************************************************************************
+void timer_cancel(sw_timer *t){
+  if(!t->pprev)
+    return;
+
+  *t->pprev = t->next;
+  if(t->next)
+    t->next->pprev = t->pprev;
+  t->pprev = 0;
+}
+
+//******************************************************************************
+// Function : unsigned char timer_pending(sw_timer *t)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns 1 if the timer is started and has not fired yet.
+//
+//******************************************************************************
+unsigned char timer_pending(sw_timer *t){
+  return t->pprev != 0;
+}
+
+//******************************************************************************
+// Function : void wheel_cascade(sw_timer **slot)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Empties a slot of an upper level and places its timers again, which moves
+// them down to a lower level now that they are closer.
+//
+//******************************************************************************
+void wheel_cascade(sw_timer **slot){
+  sw_timer *t = *slot;
+  *slot = 0;
+
+  while(t){
+    sw_timer *next = t->next;
+    wheel_insert(t);
+    t = next;
+  }
+}
+
+//******************************************************************************
+// Function : unsigned char timer_due(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns 1 if a tick has come that timer_poll has not processed yet.
+//
+//******************************************************************************
+unsigned char timer_due(void){
+  return (long)(timer_now() - wheel_ticks) >= 0;
+}
+
+//******************************************************************************
+// Function : void timer_poll(void)
+// Date and version : 10/19/26 version 1.1
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Brings the wheel up to sys_ticks. For every tick the level 0 slot of that
+// tick is emptied and the callback of each of its timers is called, after the
+// upper levels have been moved down when the tick crosses their boundary.
+// Periodic timers are placed again before their callback runs, so a callback
+// may cancel or restart its own timer.
+//
+//******************************************************************************
+void timer_poll(void){
+  unsigned long now = timer_now();
+
+  while((long)(now - wheel_ticks) >= 0){
+    unsigned char index = wheel_ticks & WHEEL_MASK;
+
+    //Move the upper levels down when this tick starts a new slot of theirs
+    if(index == 0){
+      unsigned char index_1 = (wheel_ticks >> WHEEL_BITS) & WHEEL_MASK;
+      if(index_1 == 0)
+        wheel_cascade(&wheel_2[(wheel_ticks >> (2 * WHEEL_BITS)) & WHEEL_MASK]);
+      wheel_cascade(&wheel_1[index_1]);
+    }
+
+    //Take the whole slot, timers started by the callbacks go to new slots.
+    //The wheel moves on to the next tick before they run, so a timer that is
+    //already due when it is placed again, a periodic timer while the wheel
+    //catches up or timer_start with no delay, fires on the next tick
+    //processed and not a full turn of level 0 later.
+    sw_timer *t = wheel_0[index];
+    wheel_0[index] = 0;
+    if(t)
+      t->pprev = &t;
+    wheel_ticks++;
+
+    while(t){
+      sw_timer *fired = t;
+      t = t->next;
+      if(t)
+        t->pprev = &t;
+      fired->pprev = 0;
+
+      if(fired->period){
+        fired->expires += fired->period;
+        wheel_insert(fired);
+      }
+      fired->fn();
+    }
+  }
+}
+
+/*
+*Interrupt set off by the Timer0 compare match every
+*millisecond. It advances the system tick and scans
+*the keypad, the timers that are due are run by
+*timer_poll from main().
+*/
+#pragma vector = TIMER0_COMP_vect
+__interrupt void ISR_TIMER0_COMP(void){
+  PROFILE_TICK_LATENCY();
+  PROFILE_ENTER(PROF_TIMER0);
+  
+  sys_ticks++;
+  keypad_scan();
+  
+  PROFILE_EXIT(PROF_TIMER0);
+}
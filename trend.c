@@ -0,0 +1,264 @@
+//******************************************************************************
+//
+// File Name            : trend.c
+// Title                : Sensor trend history and LCD sparkline
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ;
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Keeps the last TREND_SAMPLES readings of each source and draws them as a
+// sparkline along one line of the LCD. Each character holds two samples as
+// two bars of 0 to 8 pixels, scaled between the lowest and highest reading
+// kept, oldest on the left.
+//
+// A pair of bar heights is drawn with a user character, and the LCD only has
+// 8 of them, so they are kept as a glyph cache. The slots remember which pair
+// they hold, a frame reuses the slots that already hold a pair it needs and
+// only loads the pairs that are missing into slots it does not need. A frame
+// that would need more than 8 pairs is drawn with the heights rounded up to
+// steps of 2, then 4 pixels, which always fits. While the readings do not
+// change the page costs no more SPI time than a text page.
+//
+// Warnings             : trend_render must be called from main(), it loads
+//                        the user characters over the SPI
+// Restrictions         : none
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include <avr_macros.h>
+#include "lcd.h"
+#include "trend.h"
+
+//Bar heights run from 0 to 8 pixels, a pair of them is coded as left * 9 +
+//right, and pair 0 is a blank character
+#define BAR_LEVELS      9
+#define GLYPH_SLOTS     8
+#define GLYPH_NONE      0
+
+//Pixels of the left and right bar in a character row, with a gap between
+#define BAR_LEFT        0x18
+#define BAR_RIGHT       0x03
+
+//The history, a ring per source
+int trend_ring[TREND_SOURCES][TREND_SAMPLES];
+unsigned char trend_head[TREND_SOURCES];        //Where the next sample goes
+unsigned char trend_count[TREND_SOURCES];       //Samples kept so far
+
+//Pair of bar heights loaded in each user character
+unsigned char glyph_pair[GLYPH_SLOTS];
+
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash trend_sram_bytes =
+  sizeof(trend_ring) + sizeof(trend_head) + sizeof(trend_count)
+  + sizeof(glyph_pair);
+
+//******************************************************************************
+// Function : void trend_add(unsigned char source, int value)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Adds a reading to the history of a source, dropping the oldest once
+// TREND_SAMPLES are kept.
+//
+//******************************************************************************
+void trend_add(unsigned char source, int value){
+  unsigned char head = trend_head[source];
+
+  trend_ring[source][head] = value;
+  trend_head[source] = (head + 1) % TREND_SAMPLES;
+  if(trend_count[source] < TREND_SAMPLES)
+    trend_count[source]++;
+}
+
+//******************************************************************************
+// Function : int trend_latest(unsigned char source)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns the newest reading of a source, 0 before the first one.
+//
+//******************************************************************************
+int trend_latest(unsigned char source){
+  if(!trend_count[source])
+    return 0;
+  return trend_ring[source][(trend_head[source] + TREND_SAMPLES - 1)
+                            % TREND_SAMPLES];
+}
+
+//******************************************************************************
+// Function : unsigned char pair_code(unsigned char *heights, unsigned char i,
+//                                    unsigned char step)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns the pair code of character i, with both heights rounded up to a
+// multiple of step pixels.
+//
+//******************************************************************************
+unsigned char pair_code(unsigned char *heights, unsigned char i,
+                        unsigned char step){
+  unsigned char left = heights[2 * i];
+  unsigned char right = heights[2 * i + 1];
+
+  left = (left + step - 1) / step * step;
+  right = (right + step - 1) / step * step;
+  return left * BAR_LEVELS + right;
+}
+
+//******************************************************************************
+// Function : void load_pair(unsigned char slot, unsigned char code)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Builds the character of a pair of bar heights and loads it into a slot.
+//
+//******************************************************************************
+void load_pair(unsigned char slot, unsigned char code){
+  unsigned char left = code / BAR_LEVELS;
+  unsigned char right = code % BAR_LEVELS;
+  unsigned char rows[8];
+
+  for(unsigned char row = 0; row < 8; row++){
+    unsigned char pixels = 0;
+    if(row >= 8 - left)
+      pixels |= BAR_LEFT;
+    if(row >= 8 - right)
+      pixels |= BAR_RIGHT;
+    rows[row] = pixels;
+  }
+
+  lcd_load_glyph(slot, rows);
+  glyph_pair[slot] = code;
+}
+
+//******************************************************************************
+// Function : unsigned char trend_render(unsigned char source,
+//                                       unsigned char row, int *low,
+//                                       int *high)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Draws the history of a source as a sparkline on a line of the display
+// buffer, loading the user characters it needs that are not loaded yet.
+// Returns the number of samples drawn, and their lowest and highest values
+// in low and high. Nothing is drawn before the first sample.
+//
+//******************************************************************************
+unsigned char trend_render(unsigned char source, unsigned char row, int *low,
+                           int *high){
+  unsigned char count = trend_count[source];
+  unsigned char heights[TREND_SAMPLES];
+  unsigned char codes[LCD_COLUMNS];
+  unsigned char needed[LCD_COLUMNS];
+  unsigned char needed_count;
+  int *ring = trend_ring[source];
+
+  if(!count)
+    return 0;
+
+  //Oldest sample first, the ring is full from trend_head on once it wraps
+  unsigned char first = (trend_head[source] + TREND_SAMPLES - count)
+                        % TREND_SAMPLES;
+  int min = ring[first];
+  int max = min;
+  for(unsigned char i = 0; i < count; i++){
+    int value = ring[(first + i) % TREND_SAMPLES];
+    if(value < min)
+      min = value;
+    if(value > max)
+      max = value;
+  }
+  *low = min;
+  *high = max;
+
+  //Scale to 1..8 pixels so the lowest reading still shows, right aligned so
+  //the newest sample is always at the end of the line
+  unsigned int span = max - min;
+  unsigned char blank = TREND_SAMPLES - count;
+  for(unsigned char i = 0; i < TREND_SAMPLES; i++){
+    if(i < blank){
+      heights[i] = 0;
+    } else if(!span){
+      heights[i] = 4;
+    } else {
+      unsigned int offset = ring[(first + i - blank) % TREND_SAMPLES] - min;
+      heights[i] = 1 + ((unsigned long)offset * 7 + span / 2) / span;
+    }
+  }
+
+  //Find the pairs needed, coarser until they fit in the user characters
+  for(unsigned char step = 1; step <= 4; step <<= 1){
+    needed_count = 0;
+    for(unsigned char i = 0; i < LCD_COLUMNS; i++){
+      unsigned char code = pair_code(heights, i, step);
+      codes[i] = code;
+      if(code == GLYPH_NONE)
+        continue;
+
+      unsigned char j = 0;
+      while(j < needed_count && needed[j] != code)
+        j++;
+      if(j == needed_count)
+        needed[needed_count++] = code;
+    }
+    if(needed_count <= GLYPH_SLOTS)
+      break;
+  }
+
+  //Keep the slots that hold a pair still needed, load the rest into the
+  //slots that are free
+  unsigned char slot_needed = 0;
+  for(unsigned char slot = 0; slot < GLYPH_SLOTS; slot++){
+    for(unsigned char j = 0; j < needed_count; j++){
+      if(glyph_pair[slot] == needed[j])
+        SETBIT(slot_needed, slot);
+    }
+  }
+  for(unsigned char j = 0; j < needed_count; j++){
+    unsigned char slot = 0;
+    while(slot < GLYPH_SLOTS && glyph_pair[slot] != needed[j])
+      slot++;
+    if(slot < GLYPH_SLOTS)
+      continue;
+
+    slot = 0;
+    while(TESTBIT(slot_needed, slot))
+      slot++;
+    load_pair(slot, needed[j]);
+    SETBIT(slot_needed, slot);
+  }
+
+  //Draw the line with the slot of each pair
+  char *p = lcd_at(row, 0);
+  for(unsigned char i = 0; i < LCD_COLUMNS; i++){
+    if(codes[i] == GLYPH_NONE){
+      *p++ = ' ';
+    } else {
+      unsigned char slot = 0;
+      while(glyph_pair[slot] != codes[i])
+        slot++;
+      *p++ = slot;
+    }
+  }
+
+  return count;
+}
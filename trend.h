@@ -0,0 +1,39 @@
+//***************************************************************************
+//
+// File Name            : trend.h
+// Title                : Header file for the sensor trend history
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @  16MHz
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// This file includes all the declaration the compiler needs to
+// reference the functions and variables written in the file trend.c
+//
+// Warnings             : The sparkline uses all 8 user characters of the LCD
+// Restrictions         : none
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version
+//
+//
+//**************************************************************************
+
+//Sources kept in the history
+#define TREND_TEMP      0       //Temperature, hundredths of a degree C
+#define TREND_RH        1       //Relative humidity, hundredths of a percent
+#define TREND_CO2       2       //CO2 in ppm
+#define TREND_SOURCES   3
+
+//Samples kept per source, two to a character of the sparkline
+#define TREND_SAMPLES   32
+
+//Static SRAM of the trend module, for the SRAM budget
+extern const unsigned int __flash trend_sram_bytes;
+
+//These are the functions located in trend.c
+extern void trend_add(unsigned char source, int value);
+extern int trend_latest(unsigned char source);
+extern unsigned char trend_render(unsigned char source, unsigned char row,
+                                  int *low, int *high);
@@ -0,0 +1,37 @@
+//***************************************************************************
+//
+// File Name            : uart.h
+// Title                : Header file for the serial port module
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @  16MHz
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// This file includes all the declaration the compiler needs to 
+// reference the functions written in the file uart_drivers.c
+//
+// Warnings             : none
+// Restrictions         : Transmit only
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version 
+// 
+//
+//**************************************************************************
+
+//Baud rate of USART0, 8 data bits, no parity, 1 stop bit
+#define UART_BAUD 38400
+
+//Static SRAM of the serial port module, for the SRAM budget
+extern const unsigned int __flash uart_sram_bytes;
+
+//These are the functions located in uart_drivers.c
+extern void uart_init(void);
+extern void uart_putc(char c);
+extern void uart_puts(const char *str);
+extern void uart_puts_P(const char __flash *str);
+extern void uart_put_hex(unsigned int value);
+extern void uart_put_uint(unsigned int value);
+extern void uart_newline(void);
+extern unsigned char uart_busy(void);
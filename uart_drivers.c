@@ -0,0 +1,179 @@
+//******************************************************************************
+//
+// File Name            : uart_drivers.c
+// Title                : Serial port output
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ; 
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Polled transmit functions for USART0 (PE1/TXD0). They are used to dump
+// diagnostic data to a terminal. putchar already sends printf output to the
+// LCD, so the serial port has its own small set of print functions instead.
+//
+// Warnings             : The functions wait for the transmitter, do not call
+//                        them from an interrupt
+// Restrictions         : none
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version 
+// 
+//
+//******************************************************************************
+
+#include <iom128.h>
+#include <intrinsics.h>
+#include <avr_macros.h>
+#include "uart.h"
+
+//A character has been written since the last time the transmitter was idle
+unsigned char uart_sending;
+
+//Static SRAM of this module, for the SRAM budget
+const unsigned int __flash uart_sram_bytes = sizeof(uart_sending);
+
+//******************************************************************************
+// Function : void uart_init(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Configures USART0 for asynchronous transmit at UART_BAUD, 8 data bits, no
+// parity and 1 stop bit.
+//
+//******************************************************************************
+void uart_init(void){
+  unsigned int ubrr = (16000000UL / (16UL * UART_BAUD)) - 1;
+  
+  UBRR0H = (unsigned char)(ubrr >> 8);
+  UBRR0L = (unsigned char)ubrr;
+  UCSR0A = 0;
+  UCSR0B = (1 << TXEN0);
+  UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+}
+
+//******************************************************************************
+// Function : void uart_putc(char c)
+// Date and version : 10/19/26 version 1.1
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Waits for the transmit buffer to be empty and sends one character. The
+// transmit complete flag is cleared first so uart_busy can tell when the
+// character has left the shift register.
+//
+//******************************************************************************
+void uart_putc(char c){
+  while(!(UCSR0A & (1 << UDRE0))){
+    //Do nothing
+  }
+  UCSR0A = (1 << TXC0);                 //Clear the sent flag
+  UDR0 = c;
+  uart_sending = 1;
+}
+
+//******************************************************************************
+// Function : void uart_puts(const char *str)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sends a zero terminated string.
+//
+//******************************************************************************
+void uart_puts(const char *str){
+  while(*str)
+    uart_putc(*str++);
+}
+
+//******************************************************************************
+// Function : void uart_puts_P(const char __flash *str)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sends a zero terminated string kept in flash.
+//
+//******************************************************************************
+void uart_puts_P(const char __flash *str){
+  while(*str)
+    uart_putc(*str++);
+}
+
+//******************************************************************************
+// Function : void uart_put_hex(unsigned int value)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sends a 16 bit value as four upper case hex digits.
+//
+//******************************************************************************
+void uart_put_hex(unsigned int value){
+  for(signed char shift = 12; shift >= 0; shift -= 4){
+    unsigned char nibble = (value >> shift) & 0x0F;
+    uart_putc(nibble < 10 ? '0' + nibble : 'A' - 10 + nibble);
+  }
+}
+
+//******************************************************************************
+// Function : void uart_put_uint(unsigned int value)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Sends an unsigned value in decimal without leading zeros.
+//
+//******************************************************************************
+void uart_put_uint(unsigned int value){
+  char digits[5];
+  unsigned char count = 0;
+  
+  do{
+    digits[count++] = '0' + (value % 10);
+    value /= 10;
+  } while(value);
+  
+  while(count)
+    uart_putc(digits[--count]);
+}
+
+//******************************************************************************
+// Function : void uart_newline(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Ends a line for a terminal.
+//
+//******************************************************************************
+void uart_newline(void){
+  uart_putc('\r');
+  uart_putc('\n');
+}
+
+//******************************************************************************
+// Function : unsigned char uart_busy(void)
+// Date and version : 10/19/26 version 1.0
+// Target MCU : ATmega128A @ 16MHz
+// Author : Augusto Celis / Michael Anderson
+//
+// DESCRIPTION
+// Returns 1 while the last character sent is still being shifted out.
+//
+//******************************************************************************
+unsigned char uart_busy(void){
+  if(uart_sending && !TESTBIT(UCSR0A, TXC0))
+    return 1;
+  uart_sending = 0;
+  return 0;
+}
@@ -0,0 +1,69 @@
+//******************************************************************************
+//
+// File Name            : ui_strings.c
+// Title                : User interface strings
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @ 16MHz
+// Target Hardware      ; 
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// Every text shown on the LCD by fsm_ui.c. A string literal is copied into
+// SRAM at startup on the AVR, so keeping the 33 strings here in flash instead
+// saves 346 bytes of SRAM. They are written with lcd_write_at_P or lcd_put_P,
+// the numbers between them by the formatters in lcd_format.c.
+//
+// Warnings             : none
+// Restrictions         : none
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version 
+// 
+//
+//******************************************************************************
+
+#include "ui_strings.h"
+
+//Idle pages
+const char __flash str_time[] = "Time: ";
+const char __flash str_temp[] = "Temp:  ";
+const char __flash str_rh[] = "RH:    ";
+const char __flash str_co2[] = "CO2 ppm:  ";
+const char __flash str_trend_empty[] = "No samples yet";
+
+//Diagnostics pages
+const char __flash str_trace_task[] = "Task ";
+const char __flash str_cycles[] = " cyc";
+const char __flash str_trace_at[] = "At ";
+const char __flash str_ms[] = " ms";
+const char __flash str_trace_empty[] = "FSM trace empty";
+const char __flash str_frame[] = "Frame ";
+const char __flash str_us[] = " us";
+const char __flash str_stack_low[] = "Stack low!";
+const char __flash str_bytes[] = " bytes";
+
+//Options, help and alarm screens
+const char __flash str_options_1[] = "1:Set time/alarm";
+const char __flash str_options_2[] = "2:Toggle alarm";
+const char __flash str_2nd[] = "2nd";
+const char __flash str_instr_1[] = "1: Set time";
+const char __flash str_instr_2[] = "       or Alarm";
+const char __flash str_instr_3[] = "2: Alarm Y/N";
+const char __flash str_alarm_on[] = "Alarm is On";
+const char __flash str_alarm_off[] = "Alarm is Off";
+const char __flash str_alarm[] = "ALM: ";
+const char __flash str_zero_seconds[] = ":00";
+const char __flash str_press_any_key[] = "Press any key";
+
+//Time entry screens
+const char __flash str_enter_time[] = "Enter Time/Alarm";
+const char __flash str_enter_to_end[] = "Enter to end";
+const char __flash str_time_entered[] = "Time entered:";
+const char __flash str_time_or_alarm[] = "Time(1) Alarm(2)";
+
+//Error messages
+const char __flash str_invalid_key[] = "Invalid key!";
+const char __flash str_invalid_time[] = "Invalid time";
+const char __flash str_entry[] = "entry";
+const char __flash str_invalid_entry[] = "Invalid entry";
@@ -0,0 +1,65 @@
+//***************************************************************************
+//
+// File Name            : ui_strings.h
+// Title                : Header file for the user interface strings
+// Date                 : 10/19/26
+// Version              : 1.0
+// Target MCU           : ATmega128 @  16MHz
+// Author               : Augusto Celis / Michael Anderson
+// DESCRIPTION
+// This file includes all the declaration the compiler needs to 
+// reference the strings written in the file ui_strings.c
+//
+// Warnings             : The strings are in flash, write them with
+//                        lcd_write_at_P or lcd_put_P
+// Restrictions         : none
+// Algorithms           : none
+// References           : none
+//
+// Revision History     : Initial version 
+// 
+//
+//**************************************************************************
+
+//Idle pages
+extern const char __flash str_time[];
+extern const char __flash str_temp[];
+extern const char __flash str_rh[];
+extern const char __flash str_co2[];
+extern const char __flash str_trend_empty[];
+
+//Diagnostics pages
+extern const char __flash str_trace_task[];
+extern const char __flash str_cycles[];
+extern const char __flash str_trace_at[];
+extern const char __flash str_ms[];
+extern const char __flash str_trace_empty[];
+extern const char __flash str_frame[];
+extern const char __flash str_us[];
+extern const char __flash str_stack_low[];
+extern const char __flash str_bytes[];
+
+//Options, help and alarm screens
+extern const char __flash str_options_1[];
+extern const char __flash str_options_2[];
+extern const char __flash str_2nd[];
+extern const char __flash str_instr_1[];
+extern const char __flash str_instr_2[];
+extern const char __flash str_instr_3[];
+extern const char __flash str_alarm_on[];
+extern const char __flash str_alarm_off[];
+extern const char __flash str_alarm[];
+extern const char __flash str_zero_seconds[];
+extern const char __flash str_press_any_key[];
+
+//Time entry screens
+extern const char __flash str_enter_time[];
+extern const char __flash str_enter_to_end[];
+extern const char __flash str_time_entered[];
+extern const char __flash str_time_or_alarm[];
+
+//Error messages
+extern const char __flash str_invalid_key[];
+extern const char __flash str_invalid_time[];
+extern const char __flash str_entry[];
+extern const char __flash str_invalid_entry[];